@@ -20,6 +20,24 @@
 //  Revision: 0.3	Date: Aug 29, 2018
 //	Changed MAX_5VIN value to match the hardware setting.
 //
+//  Revision: 0.4
+//	Added I2C register map addresses REG_xxx and "board_regmap_init".
+//	Added "board_status_publish" for tear-free I2C reads of the status block.
+//	Added REG_STATUS_BLOCK SMBus block register.
+//	Added general call commands GC_xxx and "board_general_call".
+//	Added SMBALERT# on status changes, STATUS_ALERT_MASK selects the flags.
+//	Added SMBus Host Notify on AC12V loss and battery fault.
+//	Added REG_DIRTY change bitmap and "board_mark_dirty".
+//	I2C writes to REG_SHDN and REG_CHARGER now apply together at STOP.
+//	Added "board_command_get", I2C commands are queued for the main loop.
+//	I2C address from USERROW or the fw_sel_PA3 strap, REG_ADDRESS and
+//	REG_COMMAND to change it, see board_address.c.
+//	Added REG_STATS I2C traffic statistics.
+//	Added I2C bus sniffer: CMD_SNIFF_xxx, REG_SNIFF and "board_sniff_dump".
+//	Added REG_INFO descriptor block, read once by the host instead of probing.
+//	I2C ISR side of the register map moved to board_regmap.h, inlined into
+//	the ISR by the static I2C event handlers.
+//
 ****************************************************************************/
 
 #ifndef BOARD_H
@@ -47,6 +65,11 @@ union BoardStatusReg_t                       // Status byte holding flags.
 };
 
 extern union BoardStatusReg_t BoardStatusReg;
+
+// BoardStatusReg flags that assert SMBALERT# when they change:
+// ac12vStatus, dc5vStatus, chargingDone, ntcFault and batteryFault
+#define STATUS_ALERT_MASK	0xec
+
 extern uint8_t vinAdcRegH;
 extern uint8_t vinAdcRegL;
 extern uint16_t vinAdc;
@@ -68,6 +91,13 @@ void check_charger_status(void); // Check charger status
 //volatile uint16_t adc_result;	// 10-bit ADC result
 void ADC_start_conversion(void); // Start ADC function
 void ADC_get_result(void); // Get ADC result
+void board_regmap_init(void); // Install the I2C register map
+void board_status_publish(void); // Publish status registers to the I2C snapshot
+void board_mark_dirty(uint8_t reg); // Flag a REG_xxx register as changed in REG_DIRTY
+bool board_command_get(uint8_t *reg, uint8_t *value); // Take the next I2C command, from the main loop
+uint8_t board_address(void); // I2C slave address at boot
+void board_address_commit(uint8_t address); // Store the I2C slave address and reset
+void board_sniff_dump(void); // Stop the I2C sniffer and print its log on debug_PB3
 
 /****************************************************************************
   Bit and byte definitions
@@ -91,6 +121,83 @@ void ADC_get_result(void); // Get ADC result
 #define TRUE          1
 #define FALSE         0
 
+/****************************************************************************
+  I2C register map addresses
+****************************************************************************/
+#define REG_STATUS		0x00	// BoardStatusReg, read only
+#define REG_VIN_ADC_H	0x01	// vinAdcRegH, read only
+#define REG_VIN_ADC_L	0x02	// vinAdcRegL, read only
+#define REG_V5_ADC_H	0x03	// v5AdcRegH, read only
+#define REG_V5_ADC_L	0x04	// v5AdcRegL, read only
+#define REG_SHDN		0x05	// shdnReg, read/write
+#define REG_CHARGER		0x06	// chargerReg, read/write
+#define REG_DIRTY		0x07	// Bit n set: register n changed since last read, clear on read
+#define REG_ADDRESS		0x08	// I2C address: reads the current one, write a new one to commit
+#define REG_COMMAND		0x09	// Write only, CMD_xxx
+#define REG_STATUS_BLOCK	0x10	// SMBus block read of REG_STATUS..REG_V5_ADC_L
+#define REG_STATS		0x20	// I2C statistics, STATS_xxx, read only
+#define REG_SNIFF		0x30	// I2C sniffer log, i2c_sniff_log_t, times high byte first, read only
+#define REG_INFO		0xF0	// SMBus block read of the INFO_xxx descriptor, read only
+
+/****************************************************************************
+  REG_STATS, byte offsets of the I2C_0_stats counters, latched at the start
+  of every transaction. 16-bit counters sent high byte first.
+****************************************************************************/
+#define STATS_TRANSACTIONS	0	// Address matches, not counting repeated STARTs
+#define STATS_BYTES_READ	2	// Data bytes sent to the master
+#define STATS_BYTES_WRITTEN	4	// Data bytes received from the master
+#define STATS_NACKS			6	// Reads ended by a NACK of the master
+#define STATS_COLLISIONS	8	// Bus collisions, slave and Host Notify master
+#define STATS_BUS_ERRORS	10	// Bus errors, slave and Host Notify master
+#define STATS_STRETCH_MAX	12	// Longest I2C ISR in TCA0 ticks, see i2c_stats_t
+#define STATS_SIZE			14
+
+/****************************************************************************
+  REG_INFO descriptor, byte offsets after the block count. 16-bit values
+  are sent high byte first like the ADC registers.
+****************************************************************************/
+#define INFO_VERSION		0	// Register map protocol version, major << 4 | minor
+#define INFO_LAYOUT_H		1	// Fletcher-16 of address, width and flags of
+#define INFO_LAYOUT_L		2	// every register of every bank, in table order
+#define INFO_FEATURES		3	// INFO_HAS_xxx bits
+#define INFO_ADDRESS_MASK	4	// I2C_0_ADDRESS_MASK, register banks - 1
+#define INFO_ADC_BITS		5	// ADC resolution of the xxx_ADC_H/L registers
+#define INFO_MIN_12V		6	// MIN_12V..MAX_12V: VIN ADC range of a good AC12V
+#define INFO_MAX_12V		8	// MAX_12V
+#define INFO_MIN_5VIN		10	// MIN_5VIN..MAX_5VIN: VIN ADC range of a 5V input
+#define INFO_MAX_5VIN		12	// MAX_5VIN
+#define INFO_MAX_GND		14	// MAX_GND, VIN ADC of an absent input
+#define INFO_SIZE			16
+
+#define INFO_PROTOCOL_VERSION	0x04	// Board revision 0.4
+
+#define INFO_HAS_PEC		0x01	// SMBus PEC on every register access
+#define INFO_HAS_BLOCK		0x02	// REG_STATUS_BLOCK and snapshot reads
+#define INFO_HAS_ALERT		0x04	// SMBALERT# line
+#define INFO_HAS_NOTIFY		0x08	// SMBus Host Notify
+#define INFO_HAS_ARP		0x10	// SMBus ARP
+#define INFO_HAS_STATS		0x20	// REG_STATS
+#define INFO_HAS_SNIFF		0x40	// REG_SNIFF and CMD_SNIFF_xxx
+
+/****************************************************************************
+  I2C general call commands, written after the general call address 0x00.
+  0x04 and 0x06 are reserved by the I2C specification.
+****************************************************************************/
+#define GC_LATCH_SNAPSHOT	0xA0	// Latch the status block now, held until read
+#define GC_DISABLE_SUPPLY	0xA2	// shdnReg = DISABLE_SUPPLY
+#define GC_ENABLE_SUPPLY	0xA4	// shdnReg = ENABLE_SUPPLY
+#define GC_RESET_SUPPLY		0xA6	// shdnReg = RESET_SUPPLY
+
+/****************************************************************************
+  I2C commands, written to REG_COMMAND
+****************************************************************************/
+#define CMD_COMMIT_ADDRESS	0xC5	// Store REG_ADDRESS in USERROW and reset
+#define CMD_SNIFF_START		0x5A	// Clear the sniffer log and start logging
+#define CMD_SNIFF_STOP		0x5B	// Stop logging, REG_SNIFF keeps the log
+#define CMD_SNIFF_DUMP		0x5C	// Stop logging and print the log on debug_PB3
+
+#define ADDRESS_STRAP	0	// 1: low fw_sel_PA3 selects the next I2C address group
+
 /****************************************************************************
   TWI State codes
 ****************************************************************************/
@@ -0,0 +1,250 @@
+/****************************************************************************
+//  board_regmap.h
+//  I2C ISR side of the board register map
+//
+//  The register write hooks, the shadow register transaction and the
+//  general call commands run in the I2C ISR. They are static inline so
+//  that with I2C_0_STATIC_CALLBACKS i2c_slave_handlers.h inlines them into
+//  the ISR, which then makes no call at all. Otherwise board_regmap_init
+//  installs them as I2C callbacks. See board_regmap.c for the register map
+//  and the main loop side.
+//
+****************************************************************************/
+
+#ifndef BOARD_REGMAP_H
+#define BOARD_REGMAP_H
+
+#include <driver_init.h>
+#include <i2c_regmap.h>
+#include <cmd_ring.h>
+#include "board.h"
+
+#if I2C_0_REGMAP_ENABLE
+
+/****************************************************************************
+  State shared with board_regmap.c
+****************************************************************************/
+#define SHADOW_COUNT		(REG_CHARGER - REG_SHDN + 1)
+
+extern cmd_ring_t       boardCommands;	// Commands from the I2C ISR to the main loop
+extern volatile uint8_t dirtyReg;		// Change bitmap served as REG_DIRTY
+#if I2C_0_SNAPSHOT_ENABLE
+extern volatile uint8_t dirtyLatch;		// REG_DIRTY as latched with the status block
+extern uint8_t          dirtyLatched;	// dirtyLatch before the host read it
+#endif
+extern volatile uint8_t shadowReg[SHADOW_COUNT];	// Control register shadows, register - REG_SHDN
+extern uint8_t          shadowPending;	// Bit n: shadowReg[n] written, one ring entry reserved
+extern volatile uint8_t addressReg;		// REG_ADDRESS, the live address while no write is in progress
+extern uint8_t          addressNew;		// Valid address written to REG_ADDRESS, 0 if none
+extern volatile uint8_t commandReg;		// REG_COMMAND
+#if I2C_0_STATS_ENABLE
+extern volatile uint8_t statsReg[STATS_SIZE];	// REG_STATS
+#endif
+
+/****************************************************************************
+  Check a slave address: 7-bit, not reserved, first of its address group
+  (I2C_0_ADDRESS_MASK clear) so the virtual address banks stay in order
+****************************************************************************/
+static inline bool board_address_valid(uint8_t address)
+{
+	return address >= 0x08 && address <= 0x77 && !(address & I2C_0_ADDRESS_MASK);
+}
+
+/****************************************************************************
+  Control register writes. Take the write only if the ring entry for the
+  commit at STOP can be reserved, other commands of the transaction cannot
+  take it then.
+****************************************************************************/
+static inline bool board_shadow_write(const i2c_reg_t *reg)
+{
+	uint8_t bit = 1 << (reg->data - shadowReg);
+
+	if (!(shadowPending & bit)) {
+		if (!cmd_ring_reserve(&boardCommands)) {
+			return false;
+		}
+		shadowPending |= bit;
+	}
+	return true;
+}
+
+// Give back the ring entries of the pending writes
+static inline void board_shadow_release(void)
+{
+	for (uint8_t bits = shadowPending; bits; bits >>= 1) {
+		if (bits & 1) {
+			cmd_ring_release(&boardCommands);
+		}
+	}
+	shadowPending = 0;
+}
+
+/****************************************************************************
+  Address change: a valid REG_ADDRESS write is staged in addressNew,
+  REG_COMMAND queues CMD_COMMIT_ADDRESS for the main loop. Both NACK bad
+  values. The register map has already stored the byte in addressReg, it
+  is put back to the live address so that reads never return the staged
+  or a rejected value.
+****************************************************************************/
+static inline bool board_address_write(const i2c_reg_t *reg)
+{
+	uint8_t address = addressReg;
+
+	addressReg = TWI0.SADDR >> 1;
+	if (!board_address_valid(address)) {
+		return false;
+	}
+	addressNew = address;
+	return true;
+}
+
+static inline bool board_command_write(const i2c_reg_t *reg)
+{
+	switch (commandReg) {
+	case CMD_COMMIT_ADDRESS:
+		if (!addressNew) {
+			return false;
+		}
+		break;
+#if I2C_0_SNIFFER_ENABLE
+	case CMD_SNIFF_START:
+	case CMD_SNIFF_STOP:
+	case CMD_SNIFF_DUMP:
+		break;
+#endif
+	default:
+		return false;
+	}
+	return cmd_ring_put(&boardCommands, REG_COMMAND, commandReg);
+}
+
+#if I2C_0_SNAPSHOT_ENABLE
+/****************************************************************************
+  Latch REG_DIRTY, whenever the status block is latched
+****************************************************************************/
+static inline void board_dirty_latch(void)
+{
+	dirtyLatched = dirtyReg;
+	dirtyLatch   = dirtyLatched;
+}
+#endif
+
+#if I2C_0_STATS_ENABLE
+/****************************************************************************
+  REG_STATS: I2C_0_stats high byte first, see STATS_xxx in board.h
+****************************************************************************/
+static inline void board_stats_word(uint8_t offset, uint16_t value)
+{
+	statsReg[offset]     = value >> 8;
+	statsReg[offset + 1] = value;
+}
+
+static inline void board_stats_latch(void)
+{
+	board_stats_word(STATS_TRANSACTIONS, I2C_0_stats.transactions);
+	board_stats_word(STATS_BYTES_READ, I2C_0_stats.bytes_read);
+	board_stats_word(STATS_BYTES_WRITTEN, I2C_0_stats.bytes_written);
+	board_stats_word(STATS_NACKS, I2C_0_stats.nacks);
+	board_stats_word(STATS_COLLISIONS, I2C_0_stats.collisions);
+	board_stats_word(STATS_BUS_ERRORS, I2C_0_stats.bus_errors);
+	board_stats_word(STATS_STRETCH_MAX, I2C_0_stats.stretch_max);
+}
+#endif
+
+/****************************************************************************
+  Shadow register transaction, from the I2C address, STOP, collision and
+  bus error events.
+  A new transaction reads the live values into the shadows, a repeated
+  START keeps the bytes written so far. A new transaction also refreshes
+  REG_ADDRESS and latches REG_DIRTY and REG_STATS, the STOP clears the
+  REG_DIRTY bits the host read. A write transaction with a NACKed byte is
+  not applied: the host retries all of it, and RESET_SUPPLY or
+  CHARGER_RESTART must not run twice.
+****************************************************************************/
+static inline void board_shadow_begin(bool restart)
+{
+	if (!restart) {
+		shadowReg[REG_SHDN - REG_SHDN]    = shdnReg;
+		shadowReg[REG_CHARGER - REG_SHDN] = chargerReg;
+		// Nothing is pending after a STOP or an error, but never leak entries
+		board_shadow_release();
+		// An SMBus ARP Assign Address may have changed it
+		addressReg = TWI0.SADDR >> 1;
+#if I2C_0_SNAPSHOT_ENABLE
+		// The register map has just latched the status block, unless frozen
+		if (!I2C_0_snapshot.frozen) {
+			board_dirty_latch();
+		}
+#endif
+#if I2C_0_STATS_ENABLE
+		board_stats_latch();
+#endif
+	}
+}
+
+static inline void board_shadow_commit(void)
+{
+#if I2C_0_SNAPSHOT_ENABLE
+	// Bits the register map cleared in the latch went to the host
+	dirtyReg &= ~(dirtyLatched & ~dirtyLatch);
+	dirtyLatched = dirtyLatch;
+#endif
+	if (I2C_0_regmap_nacked()) {
+		board_shadow_release();
+		return;
+	}
+	// Entries were reserved by board_shadow_write
+	if (shadowPending & 1 << (REG_SHDN - REG_SHDN)) {
+		shdnReg = shadowReg[REG_SHDN - REG_SHDN];
+		cmd_ring_put_reserved(&boardCommands, REG_SHDN, shdnReg);
+	}
+	if (shadowPending & 1 << (REG_CHARGER - REG_SHDN)) {
+		chargerReg = shadowReg[REG_CHARGER - REG_SHDN];
+		cmd_ring_put_reserved(&boardCommands, REG_CHARGER, chargerReg);
+	}
+	shadowPending = 0;
+}
+
+static inline void board_shadow_drop(void)
+{
+	board_shadow_release();
+}
+
+/****************************************************************************
+  General call commands, broadcast to every board on the bus at once.
+  Return true to ACK the command. A supply command is queued for the main
+  loop and NACKed when the ring is full.
+****************************************************************************/
+static inline bool board_supply_command(uint8_t value)
+{
+	if (!cmd_ring_put(&boardCommands, REG_SHDN, value)) {
+		return false;
+	}
+	shdnReg = value;
+	dirtyReg |= 1 << (REG_SHDN - REG_STATUS);
+	return true;
+}
+
+static inline bool board_general_call(uint8_t command)
+{
+	switch (command) {
+#if I2C_0_SNAPSHOT_ENABLE
+	case GC_LATCH_SNAPSHOT:
+		I2C_0_snapshot_freeze();
+		board_dirty_latch();
+		return true;
+#endif
+	case GC_DISABLE_SUPPLY:
+		return board_supply_command(DISABLE_SUPPLY);
+	case GC_ENABLE_SUPPLY:
+		return board_supply_command(ENABLE_SUPPLY);
+	case GC_RESET_SUPPLY:
+		return board_supply_command(RESET_SUPPLY);
+	default:
+		return false;
+	}
+}
+
+#endif
+
+#endif
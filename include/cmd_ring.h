@@ -0,0 +1,162 @@
+/**
+ * \file
+ *
+ * \brief Single-producer single-consumer command ring.
+ *
+ * Hands commands from an ISR to the main loop without a critical section.
+ * Only the producer writes head and only the consumer writes tail, both
+ * are single bytes, so every access is atomic on the AVR. The indices run
+ * freely and wrap at 256, CMD_RING_SIZE must be a power of two so that
+ * head - tail is the fill level across the wrap.
+ *
+ * The producer can reserve entries for commands it will put later, e.g.
+ * at the end of a transaction whose data it has already accepted. Other
+ * puts leave the reserved entries free, so the later put cannot fail.
+ * The reservations belong to the producer side like head.
+ *
+ */
+
+#ifndef CMD_RING_H
+#define CMD_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// <o> Command ring entries <2-128>
+// <i> Power of two
+// <id> cmd_ring_size
+#ifndef CMD_RING_SIZE
+#define CMD_RING_SIZE 8
+#endif
+
+#if CMD_RING_SIZE & (CMD_RING_SIZE - 1)
+#error "CMD_RING_SIZE must be a power of two"
+#endif
+
+/** One command: what to do and its argument */
+typedef struct cmd_s {
+	uint8_t cmd; ///< Command code
+	uint8_t arg; ///< Command argument
+} cmd_t;
+
+/** Command ring, zero-initialized storage is an empty ring */
+typedef struct cmd_ring_s {
+	volatile cmd_t   entry[CMD_RING_SIZE]; ///< Commands, indexed by head/tail modulo CMD_RING_SIZE
+	volatile uint8_t head;                 ///< Next entry to fill, written by the producer only
+	volatile uint8_t tail;                 ///< Next entry to take, written by the consumer only
+	uint8_t          reserved;             ///< Entries held for cmd_ring_put_reserved, producer only
+} cmd_ring_t;
+
+/**
+ * \brief Number of commands the producer can still put
+ *
+ * \param[in] ring Command ring
+ *
+ * \return Free entries not reserved, only grows until the producer puts again
+ */
+static inline uint8_t cmd_ring_free(const cmd_ring_t *ring)
+{
+	return CMD_RING_SIZE - (uint8_t)(ring->head - ring->tail) - ring->reserved;
+}
+
+/**
+ * \brief Put a command, producer side
+ *
+ * \param[in] ring Command ring
+ * \param[in] cmd  Command code
+ * \param[in] arg  Command argument
+ *
+ * \return false if the ring is full, reserved entries included, and the
+ *         command was not put
+ */
+static inline bool cmd_ring_put(cmd_ring_t *ring, uint8_t cmd, uint8_t arg)
+{
+	uint8_t head = ring->head;
+
+	if ((uint8_t)(head - ring->tail) + ring->reserved >= CMD_RING_SIZE) {
+		return false;
+	}
+	ring->entry[head & (CMD_RING_SIZE - 1)].cmd = cmd;
+	ring->entry[head & (CMD_RING_SIZE - 1)].arg = arg;
+	// Entry is complete before the consumer can see it
+	ring->head = head + 1;
+	return true;
+}
+
+/**
+ * \brief Reserve an entry for a later cmd_ring_put_reserved, producer side
+ *
+ * \param[in] ring Command ring
+ *
+ * \return false if no entry is free and nothing was reserved
+ */
+static inline bool cmd_ring_reserve(cmd_ring_t *ring)
+{
+	if (!cmd_ring_free(ring)) {
+		return false;
+	}
+	ring->reserved++;
+	return true;
+}
+
+/**
+ * \brief Give back an entry reserved with cmd_ring_reserve, producer side
+ *
+ * \param[in] ring Command ring
+ *
+ * \return Nothing
+ */
+static inline void cmd_ring_release(cmd_ring_t *ring)
+{
+	ring->reserved--;
+}
+
+/**
+ * \brief Put a command into an entry reserved with cmd_ring_reserve
+ *
+ * Producer side. Cannot fail: the consumer only frees entries.
+ *
+ * \param[in] ring Command ring
+ * \param[in] cmd  Command code
+ * \param[in] arg  Command argument
+ *
+ * \return Nothing
+ */
+static inline void cmd_ring_put_reserved(cmd_ring_t *ring, uint8_t cmd, uint8_t arg)
+{
+	ring->reserved--;
+	cmd_ring_put(ring, cmd, arg);
+}
+
+/**
+ * \brief Take the oldest command, consumer side
+ *
+ * \param[in]  ring Command ring
+ * \param[out] cmd  Command code
+ * \param[out] arg  Command argument
+ *
+ * \return false if the ring is empty
+ */
+static inline bool cmd_ring_get(cmd_ring_t *ring, uint8_t *cmd, uint8_t *arg)
+{
+	uint8_t tail = ring->tail;
+
+	if (tail == ring->head) {
+		return false;
+	}
+	*cmd = ring->entry[tail & (CMD_RING_SIZE - 1)].cmd;
+	*arg = ring->entry[tail & (CMD_RING_SIZE - 1)].arg;
+	// Entry is read before the producer can reuse it
+	ring->tail = tail + 1;
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CMD_RING_H */
@@ -30,6 +30,18 @@
 
 #include <compiler.h>
 
+// <o> High priority interrupt vector
+// <i> Vector number of the one level 1 interrupt, which interrupts all
+// <i> level 0 handlers. 0 keeps every interrupt at level 0. The TWI slave
+// <i> vector keeps clock stretching short while the ADC and the timeout
+// <i> driver are busy, see the shared state notes in cpuint.c.
+// <0"> None
+// <TWI0_TWIS_vect_num"> TWI0 slave
+// <id> cpuint_lvl1vec
+#ifndef CPUINT_LVL1VEC
+#define CPUINT_LVL1VEC TWI0_TWIS_vect_num
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -0,0 +1,654 @@
+/**
+ * \file
+ *
+ * \brief I2C slave register map engine.
+ *
+ * The firmware declares a const table of registers, sorted by address, and
+ * the I2C slave ISR serves master reads and writes directly from it. The
+ * first byte of every write sets the register pointer, every following
+ * data byte auto-increments it, crossing from one register into the next
+ * when the addresses are contiguous. The pointer survives a repeated START
+ * and is reset to 0 at STOP.
+ *
+ * The per-byte functions are static inline so that the ISR does not pay a
+ * call per byte. They are only meant to be called from the I2C slave ISR.
+ *
+ */
+
+#ifndef I2C_REGMAP_H
+#define I2C_REGMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <i2c_slave_config.h>
+#if I2C_0_ADDRESS_MASK
+#include <compiler.h>
+#endif
+#if I2C_0_PEC_ENABLE
+#include <smbus_pec.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Register can be read by the master */
+#define I2C_REG_R 0x01
+/** Register can be written by the master */
+#define I2C_REG_W 0x02
+/** Register can be read and written by the master */
+#define I2C_REG_RW (I2C_REG_R | I2C_REG_W)
+/**
+ * SMBus block register: data[0] is the byte count, followed by up to
+ * width - 1 (at most 32) data bytes. A read returns the count and then
+ * count bytes; a write sends the count and then count bytes, a count
+ * larger than the register is NACKed. Block registers are accessed from
+ * their first byte.
+ */
+#define I2C_REG_BLOCK 0x04
+/**
+ * Clear on read: the bits the master has read are cleared at the STOP of
+ * the transaction, bits set in the meantime are kept. A collision or bus
+ * error keeps them all. Only for one byte registers, and only the last
+ * clear on read register of a transaction is cleared.
+ */
+#define I2C_REG_CLEAR 0x08
+
+/** Largest SMBus block, count byte excluded */
+#define I2C_REG_BLOCK_MAX 32
+
+struct i2c_reg;
+
+/**
+ * Typedef for the hook called once the last byte of a register has been
+ * written. The bytes are already stored; returning false NACKs the last
+ * byte so that the master sees the write was not taken.
+ */
+typedef bool (*i2c_reg_hook_t)(const struct i2c_reg *reg);
+
+/** Data structure describing one register of the map */
+typedef struct i2c_reg {
+	uint8_t           addr;     ///< Register address as seen by the master
+	uint8_t           width;    ///< Number of bytes backing the register, data[0] is transferred first
+	uint8_t           flags;    ///< I2C_REG_* access flags
+	volatile uint8_t *data;     ///< Backing storage of the register
+	i2c_reg_hook_t    on_write; ///< Optional hook called when the last byte has been written, may be NULL
+} i2c_reg_t;
+
+/** Register table answering on one of the virtual slave addresses */
+typedef struct i2c_bank {
+	const i2c_reg_t *table; ///< Register table, sorted by address
+	uint8_t          count; ///< Number of entries in the table
+} i2c_bank_t;
+
+/** Run-time state of the register map engine */
+typedef struct i2c_regmap_s {
+	const i2c_reg_t *table;   ///< Register table, sorted by address
+	const i2c_reg_t *end;     ///< One past the last entry of the table
+	const i2c_reg_t *reg;     ///< Register the pointer is in, NULL if unmapped
+	uint8_t          ptr;     ///< Register pointer
+	uint8_t          off;     ///< Byte offset of the pointer inside reg
+	bool             set_ptr; ///< Next written byte is a register pointer
+	bool             nacked;  ///< A byte written since the START was NACKed
+	volatile uint8_t *clear;     ///< Clear on read register read in this transaction, or NULL
+	uint8_t           clear_bits; ///< Bits of clear sent to the master
+#if I2C_0_PREFETCH_ENABLE
+	bool              prefetched;      ///< next holds a byte the master has not read yet
+	uint8_t           next;            ///< Byte fetched ahead for the master
+	uint8_t           next_ptr;        ///< Register pointer before next was fetched
+	volatile uint8_t *next_clear;      ///< Clear on read register next came from, or NULL
+	uint8_t           next_clear_bits; ///< Bits of next_clear in next
+#endif
+#if I2C_0_ADDRESS_MASK
+	const i2c_bank_t *banks; ///< One bank per virtual address, NULL for a single table
+#endif
+#if I2C_0_PEC_ENABLE
+	uint8_t crc;                        ///< Running PEC of the transaction, address bytes included
+	uint8_t remain;                     ///< Data bytes left before the PEC byte
+	uint8_t staged;                     ///< Written bytes held in stage, or 1 while a read PEC is pending
+	uint8_t stage[I2C_0_PEC_MAX_WIDTH]; ///< Written bytes held back until the PEC is checked
+#endif
+} i2c_regmap_t;
+
+extern i2c_regmap_t I2C_0_regmap;
+
+/** Double-buffered snapshot of a block of registers */
+typedef struct i2c_snapshot_s {
+	volatile uint8_t *buf;   ///< Three blocks of size bytes: two producer buffers, then the latched copy
+	uint8_t           size;  ///< Size of one block
+	volatile uint8_t  front; ///< Producer buffer holding the latest published block
+	uint8_t           frozen; ///< Latched copy is held for the host, see I2C_0_snapshot_freeze
+} i2c_snapshot_t;
+
+extern i2c_snapshot_t I2C_0_snapshot;
+
+/**
+ * \brief Install the register table served by the I2C slave
+ *
+ * \param[in] table Register table, sorted by ascending address, must not overlap
+ * \param[in] count Number of entries in the table
+ *
+ * \return Nothing
+ */
+void I2C_0_regmap_init(const i2c_reg_t *table, uint8_t count);
+
+#if I2C_0_ADDRESS_MASK
+/**
+ * \brief Install one register table per virtual slave address
+ *
+ * The slave answers on every address that matches its own address outside
+ * of the I2C_0_ADDRESS_MASK bits. The bank is picked from the received
+ * address: banks[(address ^ own address) & I2C_0_ADDRESS_MASK], so the
+ * own address itself serves banks[0].
+ *
+ * \param[in] banks I2C_0_ADDRESS_MASK + 1 banks, normally const
+ *
+ * \return Nothing
+ */
+void I2C_0_regmap_init_banks(const i2c_bank_t *banks);
+#endif
+
+#if I2C_0_SNAPSHOT_ENABLE
+/**
+ * \brief Install the snapshot block
+ *
+ * The registers that must be read coherently point into the latched copy,
+ * the last of the three blocks of buf. The producer fills the block
+ * returned by I2C_0_snapshot_begin and makes it visible with
+ * I2C_0_snapshot_publish, the I2C ISR copies the latest published block
+ * into the latched copy on every address match. The producer never writes
+ * the published block, so neither side needs a critical section as long
+ * as the producer does not run at a higher interrupt priority than the
+ * I2C ISR.
+ *
+ * \param[in] buf  Storage for three blocks of size bytes
+ * \param[in] size Size of the block
+ *
+ * \return Nothing
+ */
+void I2C_0_snapshot_init(volatile uint8_t *buf, uint8_t size);
+
+/**
+ * \brief Get the producer buffer to fill with the next block
+ *
+ * \return Pointer to size bytes the producer may write
+ */
+static inline volatile uint8_t *I2C_0_snapshot_begin(void)
+{
+	return I2C_0_snapshot.buf + (I2C_0_snapshot.front ? 0 : I2C_0_snapshot.size);
+}
+
+/**
+ * \brief Publish the block filled since I2C_0_snapshot_begin
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_snapshot_publish(void)
+{
+	I2C_0_snapshot.front ^= 1;
+}
+
+/**
+ * \brief Latch the latest published block for the master to read
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_snapshot_latch(void)
+{
+	volatile uint8_t *src  = I2C_0_snapshot.buf + (I2C_0_snapshot.front ? I2C_0_snapshot.size : 0);
+	volatile uint8_t *dst  = I2C_0_snapshot.buf + 2 * I2C_0_snapshot.size;
+	uint8_t           size = I2C_0_snapshot.size;
+
+	while (size--) {
+		*dst++ = *src++;
+	}
+}
+
+/**
+ * \brief Latch the latest published block now and hold it
+ *
+ * Address matches do not re-latch the block until a transaction has read
+ * it, so a broadcast latch gives time-aligned values across boards. Only
+ * call from the I2C ISR, e.g. from a general call command.
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_snapshot_freeze(void)
+{
+	I2C_0_snapshot_latch();
+	I2C_0_snapshot.frozen = 1;
+}
+#endif
+
+/**
+ * \brief Set the register pointer of the register map
+ *
+ * \param[in] ptr New value of the register pointer
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_regmap_seek(uint8_t ptr)
+{
+	const i2c_reg_t *reg = I2C_0_regmap.table;
+
+	I2C_0_regmap.ptr = ptr;
+	I2C_0_regmap.reg = NULL;
+
+	for (; reg != I2C_0_regmap.end; reg++) {
+		if (ptr < reg->addr)
+			break;
+		if ((uint8_t)(ptr - reg->addr) < reg->width) {
+			I2C_0_regmap.reg = reg;
+			I2C_0_regmap.off = ptr - reg->addr;
+			break;
+		}
+	}
+}
+
+/**
+ * \brief Index of the last byte of a register that is transferred
+ *
+ * \param[in] reg Register
+ *
+ * \return width - 1, or the byte count of a block register
+ */
+static inline uint8_t I2C_0_regmap_last(const i2c_reg_t *reg)
+{
+	uint8_t last = reg->width - 1;
+
+	if ((reg->flags & I2C_REG_BLOCK) && reg->data[0] < last) {
+		last = reg->data[0];
+	}
+	return last;
+}
+
+/**
+ * \brief Advance the register pointer by one byte
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_regmap_advance(void)
+{
+	const i2c_reg_t *reg = I2C_0_regmap.reg;
+
+	I2C_0_regmap.ptr++;
+	if (reg != NULL) {
+		if (++I2C_0_regmap.off < reg->width)
+			return;
+		// Fall through into the next register when it is contiguous
+		reg++;
+		if (reg != I2C_0_regmap.end && reg->addr == I2C_0_regmap.ptr) {
+			I2C_0_regmap.reg = reg;
+			I2C_0_regmap.off = 0;
+			return;
+		}
+	}
+	I2C_0_regmap_seek(I2C_0_regmap.ptr);
+}
+
+/**
+ * \brief Address match of this slave
+ *
+ * A write sets the register pointer with its first byte. A read starts at
+ * the current pointer, which is kept across a repeated START so that the
+ * combined format "write pointer, Sr, read N bytes" works, and reset to 0
+ * at STOP. The snapshot is only latched at the start of a transaction, so
+ * all reads of a combined transaction see the same block.
+ *
+ * With PEC the address bytes are part of the checked message, and a read
+ * returns the remaining bytes of the register at the pointer followed by
+ * the PEC byte.
+ *
+ * \param[in] read    true if the master wishes to read from the slave
+ * \param[in] restart true if this is a repeated START
+ * \param[in] addr    Received address byte, R/W bit included
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_regmap_address(bool read, bool restart, uint8_t addr)
+{
+#if I2C_0_PREFETCH_ENABLE
+	if (I2C_0_regmap.prefetched) {
+		// Repeated START after a read: the prefetched byte was never sent
+		I2C_0_regmap.prefetched = false;
+		I2C_0_regmap.next_clear = NULL;
+		I2C_0_regmap_seek(I2C_0_regmap.next_ptr);
+	}
+#endif
+#if I2C_0_ADDRESS_MASK
+	if (I2C_0_regmap.banks != NULL) {
+		const i2c_bank_t *bank = &I2C_0_regmap.banks[((addr ^ TWI0.SADDR) >> 1) & I2C_0_ADDRESS_MASK];
+
+		if (bank->table != I2C_0_regmap.table) {
+			I2C_0_regmap.table = bank->table;
+			I2C_0_regmap.end   = bank->table + bank->count;
+			I2C_0_regmap_seek(I2C_0_regmap.ptr);
+		}
+	}
+#endif
+	I2C_0_regmap.set_ptr = !read;
+	if (!restart) {
+		I2C_0_regmap.nacked = false;
+	}
+#if I2C_0_SNAPSHOT_ENABLE
+	if (I2C_0_snapshot.frozen) {
+		// Held block is released at the STOP of the transaction reading it
+		if (read) {
+			I2C_0_snapshot.frozen = 2;
+		}
+	} else if (!restart) {
+		I2C_0_snapshot_latch();
+	}
+#endif
+#if I2C_0_PEC_ENABLE
+	const i2c_reg_t *reg = I2C_0_regmap.reg;
+
+	if (!restart) {
+		I2C_0_regmap.crc = 0;
+	}
+	I2C_0_regmap.crc    = smbus_pec_update(I2C_0_regmap.crc, addr);
+	I2C_0_regmap.remain = 0;
+	I2C_0_regmap.staged = 0;
+	if (read) {
+		if (reg != NULL && (reg->flags & I2C_REG_R) && I2C_0_regmap.off <= I2C_0_regmap_last(reg)) {
+			I2C_0_regmap.remain = I2C_0_regmap_last(reg) + 1 - I2C_0_regmap.off;
+		}
+		I2C_0_regmap.staged = 1;
+	}
+#endif
+}
+
+/**
+ * \brief Remember the bits of a clear on read register sent to the master
+ *
+ * \param[in] reg  Register the byte was read from
+ * \param[in] data Byte sent to the master
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_regmap_read_clear(const i2c_reg_t *reg, uint8_t data)
+{
+	if (reg->flags & I2C_REG_CLEAR) {
+#if I2C_0_PREFETCH_ENABLE
+		// Not sent yet, see I2C_0_regmap_next
+		I2C_0_regmap.next_clear      = reg->data;
+		I2C_0_regmap.next_clear_bits = data;
+#else
+		I2C_0_regmap.clear      = reg->data;
+		I2C_0_regmap.clear_bits = data;
+#endif
+	}
+}
+
+/**
+ * \brief End of the transaction, reset the register pointer
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_regmap_stop(void)
+{
+	if (I2C_0_regmap.clear != NULL) {
+		*I2C_0_regmap.clear &= ~I2C_0_regmap.clear_bits;
+		I2C_0_regmap.clear = NULL;
+	}
+#if I2C_0_PREFETCH_ENABLE
+	I2C_0_regmap.prefetched = false;
+	I2C_0_regmap.next_clear = NULL;
+#endif
+	I2C_0_regmap.set_ptr = false;
+#if I2C_0_SNAPSHOT_ENABLE
+	if (I2C_0_snapshot.frozen == 2) {
+		I2C_0_snapshot.frozen = 0;
+	}
+#endif
+#if I2C_0_PEC_ENABLE
+	// Writes whose PEC byte never came are dropped
+	I2C_0_regmap.remain = 0;
+	I2C_0_regmap.staged = 0;
+#endif
+	I2C_0_regmap_seek(0);
+}
+
+/**
+ * \brief Transaction aborted by a collision or bus error
+ *
+ * Like I2C_0_regmap_stop, but clear on read registers keep their bits as
+ * the master may not have received them.
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_regmap_abort(void)
+{
+	I2C_0_regmap.clear = NULL;
+	I2C_0_regmap_stop();
+}
+
+/**
+ * \brief Fetch the next byte the master reads and advance the pointer
+ *
+ * \return Byte to send to the master
+ */
+static inline uint8_t I2C_0_regmap_read(void)
+{
+#if I2C_0_PEC_ENABLE
+	uint8_t data;
+
+	if (I2C_0_regmap.remain) {
+		I2C_0_regmap.remain--;
+		data = I2C_0_regmap.reg->data[I2C_0_regmap.off];
+		I2C_0_regmap_read_clear(I2C_0_regmap.reg, data);
+		I2C_0_regmap_advance();
+	} else if (I2C_0_regmap.staged) {
+		// Register done, send the PEC
+		I2C_0_regmap.staged = 0;
+		data                = I2C_0_regmap.crc;
+	} else {
+		return I2C_0_REGMAP_FILL;
+	}
+	I2C_0_regmap.crc = smbus_pec_update(I2C_0_regmap.crc, data);
+	return data;
+#else
+	const i2c_reg_t *reg  = I2C_0_regmap.reg;
+	uint8_t          data = I2C_0_REGMAP_FILL;
+
+	if (reg != NULL && (reg->flags & I2C_REG_R) && I2C_0_regmap.off <= I2C_0_regmap_last(reg)) {
+		data = reg->data[I2C_0_regmap.off];
+		I2C_0_regmap_read_clear(reg, data);
+	}
+	I2C_0_regmap_advance();
+	return data;
+#endif
+}
+
+#if I2C_0_PREFETCH_ENABLE
+/**
+ * \brief Fetch the byte the master reads next ahead of time
+ *
+ * Call after the address match of a read and after every byte sent with
+ * I2C_0_regmap_next. The pointer moves on at once and is moved back if
+ * the byte is not sent. Not for a repeated START read after a read with
+ * PEC, which is no SMBus protocol: the PEC would include the unsent byte.
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_regmap_prefetch(void)
+{
+	I2C_0_regmap.next_ptr   = I2C_0_regmap.ptr;
+	I2C_0_regmap.next       = I2C_0_regmap_read();
+	I2C_0_regmap.prefetched = true;
+}
+
+/**
+ * \brief Take the prefetched byte to send it to the master
+ *
+ * \return Byte to send to the master
+ */
+static inline uint8_t I2C_0_regmap_next(void)
+{
+	if (I2C_0_regmap.next_clear != NULL) {
+		I2C_0_regmap.clear      = I2C_0_regmap.next_clear;
+		I2C_0_regmap.clear_bits = I2C_0_regmap.next_clear_bits;
+		I2C_0_regmap.next_clear = NULL;
+	}
+	I2C_0_regmap.prefetched = false;
+	return I2C_0_regmap.next;
+}
+#endif
+
+#if I2C_0_STATIC_CALLBACKS
+/**
+ * \brief Write hooks bound at compile time, defined in i2c_slave_handlers.h
+ *
+ * Called instead of reg->on_write, so that the I2C ISR does not make an
+ * indirect call.
+ *
+ * \param[in] reg Register whose last byte has been written
+ *
+ * \return false to NACK the last byte
+ */
+bool I2C_0_regmap_write_callback(const i2c_reg_t *reg);
+#endif
+
+/**
+ * \brief Call the write hook of a register, if it has one
+ *
+ * \param[in] reg Register whose last byte has been written
+ *
+ * \return false to NACK the last byte
+ */
+static inline bool I2C_0_regmap_on_write(const i2c_reg_t *reg)
+{
+	if (reg->on_write == NULL) {
+		return true;
+	}
+#if I2C_0_STATIC_CALLBACKS
+	return I2C_0_regmap_write_callback(reg);
+#else
+	return reg->on_write(reg);
+#endif
+}
+
+/**
+ * \brief Store a byte written by the master and advance the pointer
+ *
+ * \param[in] data Byte received from the master
+ *
+ * \return Whether the byte should be ACKed
+ */
+static inline bool I2C_0_regmap_store(uint8_t data)
+{
+	const i2c_reg_t *reg = I2C_0_regmap.reg;
+
+#if I2C_0_PEC_ENABLE
+	// With PEC a write is pointer, the remaining bytes of that register, then
+	// PEC. The data bytes are only stored once the PEC byte has checked out.
+	uint8_t crc = I2C_0_regmap.crc;
+
+	I2C_0_regmap.crc = smbus_pec_update(crc, data);
+
+	if (I2C_0_regmap.set_ptr) {
+		I2C_0_regmap.set_ptr = false;
+		I2C_0_regmap_seek(data);
+		reg = I2C_0_regmap.reg;
+		if (reg != NULL && (reg->flags & I2C_REG_W) && reg->width - I2C_0_regmap.off <= I2C_0_PEC_MAX_WIDTH) {
+			I2C_0_regmap.remain = reg->width - I2C_0_regmap.off;
+		}
+		return true;
+	}
+
+	if (I2C_0_regmap.remain) {
+		I2C_0_regmap.remain--;
+		if ((reg->flags & I2C_REG_BLOCK) && I2C_0_regmap.staged == 0) {
+			// Block count, the data bytes follow
+			if (data > reg->width - 1) {
+				I2C_0_regmap.remain = 0;
+				return false;
+			}
+			I2C_0_regmap.remain = data;
+		}
+		I2C_0_regmap.stage[I2C_0_regmap.staged++] = data;
+		return true;
+	}
+
+	if (I2C_0_regmap.staged == 0) {
+		return false;
+	}
+
+	// PEC byte: it equals the CRC of everything before it
+	uint8_t staged      = I2C_0_regmap.staged;
+	I2C_0_regmap.staged = 0;
+	if (data != crc) {
+		return false;
+	}
+	for (uint8_t i = 0; i < staged; i++) {
+		reg->data[I2C_0_regmap.off + i] = I2C_0_regmap.stage[i];
+	}
+	return I2C_0_regmap_on_write(reg);
+#else
+	if (I2C_0_regmap.set_ptr) {
+		I2C_0_regmap.set_ptr = false;
+		I2C_0_regmap_seek(data);
+		return true;
+	}
+
+	if (reg == NULL || !(reg->flags & I2C_REG_W)) {
+		return false;
+	}
+
+	if (reg->flags & I2C_REG_BLOCK) {
+		// Count must fit the register, no data past the count
+		if (I2C_0_regmap.off == 0 ? data > reg->width - 1 : I2C_0_regmap.off > reg->data[0]) {
+			return false;
+		}
+	}
+
+	reg->data[I2C_0_regmap.off] = data;
+	if (I2C_0_regmap.off == I2C_0_regmap_last(reg) && !I2C_0_regmap_on_write(reg)) {
+		return false;
+	}
+	I2C_0_regmap_advance();
+	return true;
+#endif
+}
+
+/**
+ * \brief Take a byte written by the master
+ *
+ * A NACKed byte marks the whole write transaction as failed, see
+ * I2C_0_regmap_nacked.
+ *
+ * \param[in] data Byte received from the master
+ *
+ * \return Whether the byte should be ACKed
+ * \retval true The byte was accepted
+ * \retval false The pointer is in an unmapped or read-only register, the PEC is wrong or the write hook refused it
+ */
+static inline bool I2C_0_regmap_write(uint8_t data)
+{
+	if (!I2C_0_regmap_store(data)) {
+		I2C_0_regmap.nacked = true;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \brief Check whether a byte written in this transaction was NACKed
+ *
+ * The master sees the NACK and retries the whole write, so the STOP
+ * callback should not apply anything the transaction wrote. Valid from
+ * the START to the next START, repeated STARTs included.
+ *
+ * \return true if a byte was NACKed since the last START
+ */
+static inline bool I2C_0_regmap_nacked(void)
+{
+	return I2C_0_regmap.nacked;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2C_REGMAP_H */
@@ -29,6 +29,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <i2c_slave_config.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,71 @@ extern "C" {
 
 typedef void(i2c_callback)(void);
 
+typedef void(i2c_transfer_callback)(uint8_t rx_count, uint8_t tx_count);
+
+typedef bool(i2c_general_call_callback)(uint8_t command);
+
+/** Transaction buffers used by the ISR when I2C_0_BUFFER_ENABLE is set */
+typedef struct i2c_buffer_s {
+	const volatile uint8_t *tx;       ///< Data the master reads
+	volatile uint8_t *      rx;       ///< Storage for the data the master writes
+	uint8_t                 tx_size;  ///< Number of bytes in tx
+	uint8_t                 rx_size;  ///< Number of bytes rx can hold
+	uint8_t                 tx_count; ///< Bytes sent from tx in this transaction
+	uint8_t                 rx_count; ///< Bytes received into rx in this transaction
+} i2c_buffer_t;
+
+/**
+ * Traffic statistics kept when I2C_0_STATS_ENABLE is set. The counters
+ * wrap at 65536, the host works with differences. They only change
+ * between transactions, so a master reading them as registers sees a
+ * coherent set. Only read them from the I2C ISR, e.g. through the
+ * register map.
+ */
+typedef struct i2c_stats_s {
+	uint16_t transactions;  ///< Address matches, not counting repeated STARTs
+	uint16_t bytes_read;    ///< Data bytes sent to the master
+	uint16_t bytes_written; ///< Data bytes received from the master
+	uint16_t nacks;         ///< NACKs received from the master, one per ended read
+	uint16_t collisions;    ///< Bus collisions and lost arbitrations
+	uint16_t bus_errors;    ///< Misplaced START or STOP conditions
+	/**
+	 * Longest TWI interrupt in TCA0 ticks, about the longest SCL stretch.
+	 * System clock cycles, or I2C_0_SNIFFER_CLKSEL ticks while the sniffer
+	 * runs; reset when the sniffer starts and stops so it never mixes both.
+	 */
+	uint16_t stretch_max;
+} i2c_stats_t;
+
+#if I2C_0_STATS_ENABLE
+extern i2c_stats_t I2C_0_stats;
+#endif
+
+/** Sniffer event of a STOP, other events are the address byte of a START */
+#define I2C_SNIFF_STOP 0xff
+
+/** One bus event logged by the sniffer */
+typedef struct i2c_sniff_s {
+	uint8_t time[2]; ///< TCA0 count at the event, high byte first for the host
+	uint8_t event;   ///< Address byte with the R/W bit, or I2C_SNIFF_STOP
+} i2c_sniff_t;
+
+#if I2C_0_SNIFFER_ENABLE
+/**
+ * Sniffer log, the newest I2C_0_SNIFFER_SIZE events. The oldest event is
+ * at (head - count) modulo I2C_0_SNIFFER_SIZE. Events are only logged at
+ * address matches and STOPs, so a master reading the log as a register
+ * sees it unchanged until its own STOP.
+ */
+typedef struct i2c_sniff_log_s {
+	uint8_t     head;                      ///< Entry the next event goes to
+	uint8_t     count;                     ///< Events logged, up to I2C_0_SNIFFER_SIZE
+	i2c_sniff_t event[I2C_0_SNIFFER_SIZE]; ///< Events, a ring
+} i2c_sniff_log_t;
+
+extern i2c_sniff_log_t I2C_0_sniff_log;
+#endif
+
 void I2C_0_init(void);
 
 void I2C_0_open(void);
@@ -44,10 +110,48 @@ void I2C_0_close(void);
 
 void I2C_0_isr(void);
 
+bool I2C_0_is_repeated_start(void);
+
+void I2C_0_set_timing(uint8_t ctrla);
+
+void I2C_0_set_address(uint8_t address);
+
+uint8_t I2C_0_get_address(void);
+
+#if I2C_0_BUS_TIMEOUT_ENABLE
+uint8_t I2C_0_get_bus_timeouts(void);
+#endif
+
+#if I2C_0_SNIFFER_ENABLE
+void I2C_0_sniffer_start(void);
+
+void I2C_0_sniffer_stop(void);
+
+bool I2C_0_sniffer_active(void);
+#endif
+
+#if I2C_0_ALERT_ENABLE
+void I2C_0_alert_assert(void);
+
+void I2C_0_alert_release(void);
+
+bool I2C_0_alert_pending(void);
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+bool I2C_0_host_notify(uint16_t data);
+
+bool I2C_0_host_notify_busy(void);
+#endif
+
 uint8_t I2C_0_read(void);
 
 void I2C_0_write(uint8_t data);
 
+#if I2C_0_BUFFER_ENABLE
+void I2C_0_set_buffers(const volatile uint8_t *tx, uint8_t tx_size, volatile uint8_t *rx, uint8_t rx_size);
+#endif
+
 void I2C_0_enable(void);
 
 void I2C_0_send_ack(void);
@@ -56,6 +160,7 @@ void I2C_0_send_nack(void);
 
 void I2C_0_goto_unaddressed(void);
 
+#if !I2C_0_STATIC_CALLBACKS
 void I2C_0_set_read_callback(i2c_callback handler);
 
 void I2C_0_set_write_callback(i2c_callback handler);
@@ -68,6 +173,19 @@ void I2C_0_set_collision_callback(i2c_callback handler);
 
 void I2C_0_set_bus_error_callback(i2c_callback handler);
 
+#if I2C_0_GENERAL_CALL_ENABLE
+void I2C_0_set_general_call_callback(i2c_general_call_callback handler);
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+void I2C_0_set_notify_error_callback(i2c_callback handler);
+#endif
+
+#if I2C_0_BUFFER_ENABLE
+void I2C_0_set_transfer_callback(i2c_transfer_callback handler);
+#endif
+#endif
+
 #ifdef __cplusplus
 }
 #endif
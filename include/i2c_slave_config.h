@@ -0,0 +1,307 @@
+/**
+ * \file
+ *
+ * \brief I2C slave driver configuration.
+ *
+ * Compile-time options for the I2C slave driver and the subsystems layered
+ * on top of it. Every option can be overridden from the compiler command
+ * line, e.g. -DI2C_0_REGMAP_ENABLE=0.
+ *
+ */
+
+#ifndef I2C_SLAVE_CONFIG_H
+#define I2C_SLAVE_CONFIG_H
+
+// <o> Slave address <0x08-0x77>
+// <i> Address at reset, I2C_0_set_address changes it at run time
+// <id> i2c_0_address
+#ifndef I2C_0_ADDRESS
+#define I2C_0_ADDRESS 0x3e
+#endif
+
+// <o> Virtual address mask <0x00-0x07>
+// <i> Address bits the slave does not care about. With a non-zero mask the
+// <i> slave answers on every address that differs from its address only
+// <i> in these bits, and the register map picks one register bank per
+// <i> address. 0 answers on the slave address only.
+// <id> i2c_0_address_mask
+#ifndef I2C_0_ADDRESS_MASK
+#define I2C_0_ADDRESS_MASK 0
+#endif
+
+// <q> Fast-mode Plus
+// <i> Enable the Fm+ (1 MHz) drive strength and timing of the TWI pins.
+// <i> The slave follows any master clock up to 1 MHz, but a byte then
+// <i> only lasts 9 us: see I2C_0_ISR_CYCLES for the CPU clock needed to
+// <i> keep up without stretching SCL.
+// <id> i2c_0_fmplus_enable
+#ifndef I2C_0_FMPLUS_ENABLE
+#define I2C_0_FMPLUS_ENABLE 0
+#endif
+
+// <o> SDA hold time
+// <0=> Off
+// <1=> 50 ns
+// <2=> 300 ns, SMBus
+// <3=> 500 ns
+// <id> i2c_0_sda_hold
+#ifndef I2C_0_SDA_HOLD
+#define I2C_0_SDA_HOLD 0
+#endif
+
+// <o> SDA setup time
+// <0=> 4 clock cycles
+// <1=> 8 clock cycles
+// <id> i2c_0_sda_setup
+#ifndef I2C_0_SDA_SETUP
+#define I2C_0_SDA_SETUP 0
+#endif
+
+// <o> Worst case I2C ISR cycles per byte
+// <i> Estimate for the register map path, entry and exit included. The
+// <i> build warns when F_CPU cannot serve a byte within one byte time at
+// <i> the Fm+ rate.
+// <id> i2c_0_isr_cycles
+#ifndef I2C_0_ISR_CYCLES
+#define I2C_0_ISR_CYCLES (I2C_0_FAST_PATH_ENABLE ? 60 : 120)
+#endif
+
+// <q> General call
+// <i> Recognize the general call address 0x00. The command bytes of a
+// <i> general call write go to the general call callback instead of the
+// <i> register map.
+// <id> i2c_0_general_call_enable
+#ifndef I2C_0_GENERAL_CALL_ENABLE
+#define I2C_0_GENERAL_CALL_ENABLE 1
+#endif
+
+// <q> SMBALERT#
+// <i> Drive a spare pin open drain low to ask the host for attention, and
+// <i> answer the SMBus Alert Response Address with the slave address. Uses
+// <i> the second address match, so it cannot be combined with
+// <i> I2C_0_ADDRESS_MASK.
+// <id> i2c_0_alert_enable
+#ifndef I2C_0_ALERT_ENABLE
+#define I2C_0_ALERT_ENABLE 0
+#endif
+
+// <o> SMBALERT# port and pin
+// <i> PB2 is not used by the board firmware.
+#ifndef I2C_0_ALERT_PORT
+#define I2C_0_ALERT_PORT PORTB
+#endif
+#ifndef I2C_0_ALERT_PIN
+#define I2C_0_ALERT_PIN 2
+#endif
+
+// SMBus Alert Response Address
+#define I2C_0_ALERT_RESPONSE_ADDRESS 0x0c
+
+// <q> SMBus Host Notify
+// <i> Use the TWI master to send SMBus Host Notify messages to the host
+// <i> address 0x08 with I2C_0_host_notify. The master waits for the bus to
+// <i> go idle and the slave keeps answering while the master is enabled.
+// <id> i2c_0_host_notify_enable
+#ifndef I2C_0_HOST_NOTIFY_ENABLE
+#define I2C_0_HOST_NOTIFY_ENABLE 0
+#endif
+
+// <o> Host Notify SCL frequency in Hz
+// <id> i2c_0_master_frequency
+#ifndef I2C_0_MASTER_FREQUENCY
+#define I2C_0_MASTER_FREQUENCY 100000
+#endif
+
+// <o> Host Notify retries after a lost arbitration or bus error
+// <id> i2c_0_host_notify_retries
+#ifndef I2C_0_HOST_NOTIFY_RETRIES
+#define I2C_0_HOST_NOTIFY_RETRIES 3
+#endif
+
+// SMBus Host address, the destination of Host Notify messages
+#define I2C_0_HOST_NOTIFY_ADDRESS 0x08
+
+// <q> Bus stuck recovery
+// <i> Reset the TWI slave when it stays addressed without any bus activity
+// <i> for I2C_0_BUS_TIMEOUT_MS, e.g. because the master died while the
+// <i> slave held SDA low. Runs on the timeout driver, so the main loop must
+// <i> call TIMER_0_timeout_call_next_callback.
+// <id> i2c_0_bus_timeout_enable
+#ifndef I2C_0_BUS_TIMEOUT_ENABLE
+#define I2C_0_BUS_TIMEOUT_ENABLE 0
+#endif
+
+// <o> Bus stuck timeout in ms
+// <i> SMBus slaves must release the bus within 25 to 35 ms
+// <id> i2c_0_bus_timeout_ms
+#ifndef I2C_0_BUS_TIMEOUT_MS
+#define I2C_0_BUS_TIMEOUT_MS 35
+#endif
+
+// <o> Bus stuck check period in ms
+// <i> A stuck bus is detected between I2C_0_BUS_TIMEOUT_MS minus one period
+// <i> and I2C_0_BUS_TIMEOUT_MS
+// <id> i2c_0_bus_check_ms
+#ifndef I2C_0_BUS_CHECK_MS
+#define I2C_0_BUS_CHECK_MS 5
+#endif
+
+// <q> SMBus Address Resolution Protocol
+// <i> Answer the SMBus Device Default Address 0x61 with a UDID built from
+// <i> the SIGROW serial number so that the host can enumerate the boards
+// <i> and assign their addresses. Uses the second address match, so it
+// <i> cannot be combined with I2C_0_ADDRESS_MASK or I2C_0_ALERT_ENABLE.
+// <id> i2c_0_arp_enable
+#ifndef I2C_0_ARP_ENABLE
+#define I2C_0_ARP_ENABLE 0
+#endif
+
+// <o> ARP UDID vendor ID
+// <id> i2c_0_arp_vendor_id
+#ifndef I2C_0_ARP_VENDOR_ID
+#define I2C_0_ARP_VENDOR_ID 0xffff
+#endif
+
+// <o> ARP UDID device ID
+// <id> i2c_0_arp_device_id
+#ifndef I2C_0_ARP_DEVICE_ID
+#define I2C_0_ARP_DEVICE_ID 0x0414
+#endif
+
+// <q> Traffic statistics
+// <i> Count transactions, bytes, NACKs, collisions and bus errors and keep
+// <i> the longest TWI interrupt in I2C_0_stats. Times every TWI interrupt
+// <i> with two TCA0.SINGLE.CNT reads and a TEMP save, which costs cycles on
+// <i> every byte. TCA0 is not free running: the timeout driver reloads CNT,
+// <i> but never while the TWI interrupt runs, so the difference holds.
+// <id> i2c_0_stats_enable
+#ifndef I2C_0_STATS_ENABLE
+#define I2C_0_STATS_ENABLE 0
+#endif
+
+// <q> Bus sniffer
+// <i> Diagnostic mode started with I2C_0_sniffer_start: the slave turns on
+// <i> promiscuous mode and logs the address byte of every START and every
+// <i> STOP on the bus with a TCA0 timestamp. The bus stuck check is paused
+// <i> and TCA0 runs free with I2C_0_SNIFFER_CLKSEL while sniffing, so the
+// <i> timeout driver must not have other timers.
+// <id> i2c_0_sniffer_enable
+#ifndef I2C_0_SNIFFER_ENABLE
+#define I2C_0_SNIFFER_ENABLE 0
+#endif
+
+// <o> Sniffer log entries <2-32>
+// <i> Power of two, 3 bytes of RAM each. The board serves the log as one
+// <i> register, 32 entries fill the space up to the next one.
+// <id> i2c_0_sniffer_size
+#ifndef I2C_0_SNIFFER_SIZE
+#define I2C_0_SNIFFER_SIZE 16
+#endif
+
+// <o> Sniffer timestamp clock
+// <i> TCA0 clock while sniffing, DIV64 at 3.33 MHz wraps after 1.26 s
+// <TCA_SINGLE_CLKSEL_DIV1_gc"> System clock
+// <TCA_SINGLE_CLKSEL_DIV8_gc"> System clock / 8
+// <TCA_SINGLE_CLKSEL_DIV64_gc"> System clock / 64
+// <TCA_SINGLE_CLKSEL_DIV1024_gc"> System clock / 1024
+// <id> i2c_0_sniffer_clksel
+#ifndef I2C_0_SNIFFER_CLKSEL
+#define I2C_0_SNIFFER_CLKSEL TCA_SINGLE_CLKSEL_DIV64_gc
+#endif
+
+// <q> Register map engine
+// <i> Serve master reads and writes directly from a const register table
+// <i> with an auto-incrementing register pointer. The read and write
+// <i> callbacks are not used when this is enabled.
+// <id> i2c_0_regmap_enable
+#ifndef I2C_0_REGMAP_ENABLE
+#define I2C_0_REGMAP_ENABLE 1
+#endif
+
+// <o> Register map fill byte
+// <i> Value returned to the master when reading an unmapped register
+// <id> i2c_0_regmap_fill
+#ifndef I2C_0_REGMAP_FILL
+#define I2C_0_REGMAP_FILL 0xff
+#endif
+
+// <q> Register snapshot
+// <i> Latch a coherent copy of a double-buffered register block on every
+// <i> address match, so multi-byte values cannot tear between two reads.
+// <i> Requires the register map engine.
+// <id> i2c_0_snapshot_enable
+#ifndef I2C_0_SNAPSHOT_ENABLE
+#define I2C_0_SNAPSHOT_ENABLE I2C_0_REGMAP_ENABLE
+#endif
+
+// <q> SMBus Packet Error Checking
+// <i> Register map only. Append a PEC byte to every register read and
+// <i> require a valid PEC after every register write: the written bytes
+// <i> are held back and NACKed with the PEC byte if it does not match.
+// <id> i2c_0_pec_enable
+#ifndef I2C_0_PEC_ENABLE
+#define I2C_0_PEC_ENABLE 0
+#endif
+
+// <o> Widest register that can be written with PEC <1-33>
+// <i> Written bytes are staged in RAM until the PEC is checked. A block
+// <i> register needs its count byte plus its data bytes.
+// <id> i2c_0_pec_max_width
+#ifndef I2C_0_PEC_MAX_WIDTH
+#define I2C_0_PEC_MAX_WIDTH 2
+#endif
+
+// <q> Nibble PEC table
+// <i> Use a 16 byte lookup table and two lookups per byte instead of a
+// <i> 256 byte table and one lookup.
+// <id> i2c_0_pec_nibble_table
+#ifndef I2C_0_PEC_NIBBLE_TABLE
+#define I2C_0_PEC_NIBBLE_TABLE 0
+#endif
+
+// <q> Register map read prefetch
+// <i> Fetch the next byte the master reads from the register map right
+// <i> after sending the current one, while it is on the wire. A data
+// <i> interrupt then only writes the prefetched byte and releases SCL, so
+// <i> the clock is stretched for a fixed, short time per read byte. Values
+// <i> are sampled one byte ahead of the master.
+// <id> i2c_0_prefetch_enable
+#ifndef I2C_0_PREFETCH_ENABLE
+#define I2C_0_PREFETCH_ENABLE 0
+#endif
+
+// <q> Buffer transaction API
+// <i> Serve master reads and writes from the buffers handed over with
+// <i> I2C_0_set_buffers and call the transfer callback once at STOP,
+// <i> instead of calling the read and write callbacks per byte.
+// <i> Mutually exclusive with the register map engine.
+// <id> i2c_0_buffer_enable
+#ifndef I2C_0_BUFFER_ENABLE
+#define I2C_0_BUFFER_ENABLE 0
+#endif
+
+// <q> Assembler read byte fast path
+// <i> Buffer transaction API only. The TWI slave vector is the hand written
+// <i> one in i2c_slave_fast.S: it serves read data bytes from the tx buffer
+// <i> in about 40 cycles to the SCL release and 60 in total, and calls the
+// <i> C handler for all other events. Cannot be combined with the
+// <i> statistics, SMBALERT# or ARP, which need the C handler for every byte.
+// <id> i2c_0_fast_path_enable
+#ifndef I2C_0_FAST_PATH_ENABLE
+#define I2C_0_FAST_PATH_ENABLE 0
+#endif
+
+// <q> Compile-time bound callbacks
+// <i> Take the event handlers from the static inline functions in
+// <i> i2c_slave_handlers.h instead of the I2C_0_set_*_callback function
+// <i> pointers. The ISR then inlines them, skips the indirect call and NULL
+// <i> check per byte, and only saves the registers it actually uses.
+// <i> With the register map, the handlers inline the board's functions of
+// <i> board_regmap.h, register write hooks included, see
+// <i> i2c_slave_handlers.h.
+// <id> i2c_0_static_callbacks
+#ifndef I2C_0_STATIC_CALLBACKS
+#define I2C_0_STATIC_CALLBACKS 0
+#endif
+
+#endif /* I2C_SLAVE_CONFIG_H */
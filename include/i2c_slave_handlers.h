@@ -0,0 +1,168 @@
+/**
+ * \file
+ *
+ * \brief I2C slave event handlers bound at compile time.
+ *
+ * Only used when I2C_0_STATIC_CALLBACKS is set in i2c_slave_config.h. The
+ * handlers are included into the I2C slave driver and inlined into its
+ * ISR, so keep them short and do not call out-of-line functions from them:
+ * a single call makes the ISR save every call-clobbered register again.
+ *
+ * The read and write handlers are not used when the register map engine
+ * (I2C_0_REGMAP_ENABLE) serves the data bytes. The register write hooks
+ * of the engine are bound here as well, see I2C_0_regmap_write_callback.
+ * The register map of the board then takes the address, STOP, error and
+ * general call events and the register write hooks, with the static
+ * inline functions of board_regmap.h that board_regmap_init installs as
+ * callbacks otherwise.
+ *
+ * Included by the driver after its own state, the handlers may use
+ * I2C_0_addressed: it is still false in the address handler of a new
+ * transaction.
+ *
+ */
+
+#ifndef I2C_SLAVE_HANDLERS_H
+#define I2C_SLAVE_HANDLERS_H
+
+#if I2C_0_REGMAP_ENABLE
+#include "board_regmap.h"
+#endif
+
+/**
+ * \brief Master wishes to read a byte, write it with I2C_0_write
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_read_callback(void)
+{
+}
+
+/**
+ * \brief Master has written a byte, fetch it with I2C_0_read and ACK or NACK it
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_write_callback(void)
+{
+}
+
+/**
+ * \brief Slave has received its address
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_address_callback(void)
+{
+#if I2C_0_REGMAP_ENABLE
+	board_shadow_begin(I2C_0_addressed);
+#endif
+}
+
+/**
+ * \brief Slave has received a STOP condition after being addressed
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_stop_callback(void)
+{
+#if I2C_0_REGMAP_ENABLE
+	board_shadow_commit();
+#endif
+}
+
+/**
+ * \brief Slave has detected a bus collision
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_collision_callback(void)
+{
+#if I2C_0_REGMAP_ENABLE
+	board_shadow_drop();
+#endif
+}
+
+/**
+ * \brief Slave has detected a bus error
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_bus_error_callback(void)
+{
+#if I2C_0_REGMAP_ENABLE
+	board_shadow_drop();
+#endif
+}
+
+#if I2C_0_GENERAL_CALL_ENABLE
+/**
+ * \brief Command byte received with a general call
+ *
+ * \param[in] command Byte written by the master after the general call address
+ *
+ * \return true to ACK the command, false to NACK it
+ */
+static inline bool I2C_0_general_call_callback(uint8_t command)
+{
+#if I2C_0_REGMAP_ENABLE
+	return board_general_call(command);
+#else
+	return false;
+#endif
+}
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+/**
+ * \brief Host Notify master lost arbitration or saw a bus error, it retries
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_notify_error_callback(void)
+{
+}
+#endif
+
+#if I2C_0_BUFFER_ENABLE
+/**
+ * \brief End of a transaction in buffer mode, see I2C_0_set_buffers
+ *
+ * \param[in] rx_count Bytes received into the rx buffer
+ * \param[in] tx_count Bytes sent from the tx buffer
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_transfer_callback(uint8_t rx_count, uint8_t tx_count)
+{
+}
+#endif
+
+#if I2C_0_REGMAP_ENABLE
+/**
+ * \brief Register write hook, see I2C_0_regmap_write_callback in i2c_regmap.h
+ *
+ * Has external linkage as i2c_regmap.h declares it, but is always inlined
+ * into the ISR. The hooks of the board register map are told apart by the
+ * storage of the register and called directly, so that they are inlined
+ * too. There is no indirect call for other hooks, that would bring back
+ * the register saving: a new hook must be added here.
+ *
+ * \param[in] reg Register whose last byte has been written
+ *
+ * \return false to NACK the last byte
+ */
+inline __attribute__((always_inline)) bool I2C_0_regmap_write_callback(const i2c_reg_t *reg)
+{
+	if (reg->data == &addressReg) {
+		return board_address_write(reg);
+	}
+	if (reg->data == &commandReg) {
+		return board_command_write(reg);
+	}
+	// REG_SHDN and REG_CHARGER
+	return board_shadow_write(reg);
+}
+#endif
+
+#endif /* I2C_SLAVE_HANDLERS_H */
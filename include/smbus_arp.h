@@ -0,0 +1,208 @@
+/**
+ * \file
+ *
+ * \brief SMBus Address Resolution Protocol for the I2C slave.
+ *
+ * The slave answers the SMBus Device Default Address 0x61 with the second
+ * address match of the TWI and takes part in ARP: Prepare to ARP, Reset
+ * Device (general and directed), Get UDID (general and directed) and
+ * Assign Address, all with PEC. Several boards answer Get UDID at once,
+ * the TWI arbitration lets the lowest UDID through and the others see a
+ * collision and drop out until the next Get UDID.
+ *
+ * The UDID is built from the I2C_0_ARP_* options and the SIGROW serial
+ * number, so every chip has its own. The address type is "dynamic and
+ * volatile": an assigned address is not stored and lasts until reset.
+ * The slave starts on its own address, with AV set as that address is
+ * valid.
+ *
+ * The per-byte functions are static inline, only call them from the I2C
+ * slave ISR.
+ *
+ */
+
+#ifndef SMBUS_ARP_H
+#define SMBUS_ARP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <compiler.h>
+#include <i2c_slave_config.h>
+#include <i2c_slave.h>
+#include <smbus_pec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** SMBus Device Default Address */
+#define SMBUS_ARP_ADDRESS 0x61
+
+/** ARP commands */
+#define SMBUS_ARP_PREPARE 0x01
+#define SMBUS_ARP_RESET 0x02
+#define SMBUS_ARP_GET_UDID 0x03
+#define SMBUS_ARP_ASSIGN 0x04
+
+/** UDID length, and the Get UDID / Assign Address block count */
+#define SMBUS_ARP_UDID_SIZE 16
+#define SMBUS_ARP_BLOCK_COUNT (SMBUS_ARP_UDID_SIZE + 1)
+
+/** Address Resolved and Address Valid flags */
+#define SMBUS_ARP_AR 0x01
+#define SMBUS_ARP_AV 0x02
+
+/** Run-time state of the ARP handler */
+typedef struct i2c_arp_s {
+	uint8_t udid[SMBUS_ARP_UDID_SIZE]; ///< Unique device identifier, sent first byte first
+	uint8_t flags;                     ///< SMBUS_ARP_AR and SMBUS_ARP_AV
+	uint8_t cmd;                       ///< Command of the transaction
+	uint8_t index;                     ///< Bytes of the command or the answer transferred so far
+	uint8_t crc;                       ///< Running PEC of the transaction
+	uint8_t assign;                    ///< Address byte of Assign Address
+	bool    match;                     ///< UDID of Assign Address matches so far
+	bool    answer;                    ///< This slave answers the read of the transaction
+} i2c_arp_t;
+
+extern i2c_arp_t I2C_0_arp;
+
+/**
+ * \brief Build the UDID and reset the ARP flags, the address is valid
+ *
+ * \return Nothing
+ */
+void I2C_0_arp_init(void);
+
+/**
+ * \brief Directed command for this slave
+ *
+ * \param[in] cmd Command byte
+ *
+ * \return true if cmd carries this slave's address and the address is valid
+ */
+static inline bool I2C_0_arp_directed(uint8_t cmd)
+{
+	return (I2C_0_arp.flags & SMBUS_ARP_AV) && (cmd | 1) == (TWI0.SADDR | 1);
+}
+
+/**
+ * \brief Address match on the Device Default Address
+ *
+ * \param[in] read    true if the master wishes to read from the slave
+ * \param[in] restart true if this is a repeated START
+ * \param[in] addr    Received address byte, R/W bit included
+ *
+ * \return Nothing
+ */
+static inline void I2C_0_arp_address(bool read, bool restart, uint8_t addr)
+{
+	if (!restart) {
+		I2C_0_arp.crc = 0;
+		I2C_0_arp.cmd = 0;
+	}
+	I2C_0_arp.crc   = smbus_pec_update(I2C_0_arp.crc, addr);
+	I2C_0_arp.index = 0;
+	if (read) {
+		// Get UDID: general only while unresolved, directed if it is ours
+		I2C_0_arp.answer = I2C_0_arp.cmd == SMBUS_ARP_GET_UDID ? !(I2C_0_arp.flags & SMBUS_ARP_AR)
+		                                                       : (I2C_0_arp.cmd & 1) && I2C_0_arp_directed(I2C_0_arp.cmd);
+	} else {
+		I2C_0_arp.match = true;
+	}
+}
+
+/**
+ * \brief Fetch the next Get UDID byte: count, UDID, address, PEC
+ *
+ * Sends 0xff, which leaves the bus to the other devices, if this slave
+ * does not answer.
+ *
+ * \return Byte to send to the master
+ */
+static inline uint8_t I2C_0_arp_read(void)
+{
+	uint8_t index = I2C_0_arp.index++;
+	uint8_t data;
+
+	if (!I2C_0_arp.answer || index > SMBUS_ARP_BLOCK_COUNT + 1) {
+		return 0xff;
+	}
+	if (index == 0) {
+		data = SMBUS_ARP_BLOCK_COUNT;
+	} else if (index <= SMBUS_ARP_UDID_SIZE) {
+		data = I2C_0_arp.udid[index - 1];
+	} else if (index == SMBUS_ARP_BLOCK_COUNT) {
+		data = (I2C_0_arp.flags & SMBUS_ARP_AV) ? TWI0.SADDR | 1 : 0xff;
+	} else {
+		return I2C_0_arp.crc;
+	}
+	I2C_0_arp.crc = smbus_pec_update(I2C_0_arp.crc, data);
+	return data;
+}
+
+/**
+ * \brief Store a byte written by the master
+ *
+ * Commands take effect once their PEC byte has checked out.
+ *
+ * \param[in] data Byte received from the master
+ *
+ * \return Whether the byte should be ACKed
+ */
+static inline bool I2C_0_arp_write(uint8_t data)
+{
+	uint8_t index = I2C_0_arp.index++;
+	uint8_t crc   = I2C_0_arp.crc;
+	uint8_t cmd   = I2C_0_arp.cmd;
+
+	I2C_0_arp.crc = smbus_pec_update(crc, data);
+
+	if (index == 0) {
+		I2C_0_arp.cmd = data;
+		return data == SMBUS_ARP_PREPARE || data == SMBUS_ARP_RESET || data == SMBUS_ARP_GET_UDID
+		       || data == SMBUS_ARP_ASSIGN || I2C_0_arp_directed(data);
+	}
+
+	if (cmd != SMBUS_ARP_ASSIGN) {
+		// Get UDID has no data, it continues with a repeated START read
+		if (cmd == SMBUS_ARP_GET_UDID || (cmd > SMBUS_ARP_ASSIGN && (cmd & 1))) {
+			return false;
+		}
+		// Prepare to ARP, Reset Device and directed Reset Device: PEC only
+		if (index != 1 || data != crc) {
+			return false;
+		}
+		I2C_0_arp.flags &= ~SMBUS_ARP_AR;
+		return true;
+	}
+
+	// Assign Address: count, UDID, address, PEC
+	if (index == 1) {
+		return data == SMBUS_ARP_BLOCK_COUNT;
+	}
+	if (index <= SMBUS_ARP_UDID_SIZE + 1) {
+		if (data != I2C_0_arp.udid[index - 2]) {
+			I2C_0_arp.match = false;
+		}
+		return true;
+	}
+	if (index == SMBUS_ARP_UDID_SIZE + 2) {
+		I2C_0_arp.assign = data;
+		return true;
+	}
+	if (index != SMBUS_ARP_UDID_SIZE + 3 || data != crc) {
+		return false;
+	}
+	if (I2C_0_arp.match) {
+		// I2C_0_set_address without the call, this is the ISR
+		TWI0.SADDR      = (I2C_0_arp.assign & TWI_ADDRMASK_gm) | I2C_0_GENERAL_CALL_ENABLE << TWI_ADDREN_bp;
+		I2C_0_arp.flags = SMBUS_ARP_AR | SMBUS_ARP_AV;
+	}
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMBUS_ARP_H */
@@ -0,0 +1,52 @@
+/**
+ * \file
+ *
+ * \brief SMBus Packet Error Checking.
+ *
+ * CRC-8 with polynomial x^8 + x^2 + x + 1 (0x07), initial value 0, as
+ * used by the SMBus PEC byte. The lookup table is const, so on tinyAVR it
+ * stays in the memory mapped flash and is read with a plain load.
+ *
+ */
+
+#ifndef SMBUS_PEC_H
+#define SMBUS_PEC_H
+
+#include <stdint.h>
+#include <i2c_slave_config.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if I2C_0_PEC_NIBBLE_TABLE
+extern const uint8_t smbus_pec_table[16];
+#else
+extern const uint8_t smbus_pec_table[256];
+#endif
+
+/**
+ * \brief Add one byte to a running PEC
+ *
+ * \param[in] crc  PEC of the bytes so far, 0 at the start of a message
+ * \param[in] data Next byte of the message
+ *
+ * \return PEC including data
+ */
+static inline uint8_t smbus_pec_update(uint8_t crc, uint8_t data)
+{
+#if I2C_0_PEC_NIBBLE_TABLE
+	crc ^= data;
+	crc = (uint8_t)(crc << 4) ^ smbus_pec_table[crc >> 4];
+	crc = (uint8_t)(crc << 4) ^ smbus_pec_table[crc >> 4];
+	return crc;
+#else
+	return smbus_pec_table[crc ^ data];
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMBUS_PEC_H */
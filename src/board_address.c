@@ -0,0 +1,68 @@
+/****************************************************************************
+//  board_address.c
+//  I2C slave address of the custom power board
+//
+//  The address is chosen at boot:
+//    1. the address stored in USERROW, if one was committed, else
+//    2. I2C_0_ADDRESS from i2c_slave_config.h. With ADDRESS_STRAP, a low
+//       fw_sel_PA3 (jumper to GND) moves the board to the next address
+//       group, so two boards on one bus only need different jumpers.
+//
+//  The host changes the stored address by writing REG_ADDRESS and then
+//  CMD_COMMIT_ADDRESS to REG_COMMAND, board_address_valid in board_regmap.h
+//  checks it. The main loop writes USERROW and resets the board, which
+//  comes back on the new address. USERROW is kept over a chip erase, so
+//  the address survives firmware updates.
+//
+****************************************************************************/
+
+#include <driver_init.h>
+#include <rstctrl.h>
+#include <ccp.h>
+#include "board_regmap.h"
+
+#if I2C_0_REGMAP_ENABLE
+
+// USERROW bytes holding the address and its complement
+#define USERROW_ADDRESS		(*(volatile uint8_t *)(USER_SIGNATURES_START + 0))
+#define USERROW_ADDRESS_INV	(*(volatile uint8_t *)(USER_SIGNATURES_START + 1))
+
+/****************************************************************************
+  Boot address of the board
+****************************************************************************/
+uint8_t board_address(void)
+{
+	uint8_t address = USERROW_ADDRESS;
+
+	if ((uint8_t)(address ^ USERROW_ADDRESS_INV) == 0xff && board_address_valid(address)) {
+		return address;
+	}
+	address = I2C_0_ADDRESS;
+#if ADDRESS_STRAP
+	if (!fw_sel_PA3_get_level()) {
+		address += I2C_0_ADDRESS_MASK + 1;
+	}
+#endif
+	return address;
+}
+
+/****************************************************************************
+  Store a new address in USERROW and reset, does not return.
+  Called from the main loop after CMD_COMMIT_ADDRESS, by then the host has
+  finished the write transaction.
+****************************************************************************/
+void board_address_commit(uint8_t address)
+{
+	cli();
+	while (NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm)
+		;
+	// Load the page buffer, erase/write only touches the loaded bytes
+	USERROW_ADDRESS     = address;
+	USERROW_ADDRESS_INV = ~address;
+	ccp_write_spm((void *)&NVMCTRL.CTRLA, NVMCTRL_CMD_PAGEERASEWRITE_gc);
+	while (NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm)
+		;
+	RSTCTRL_reset();
+}
+
+#endif
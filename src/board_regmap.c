@@ -0,0 +1,415 @@
+/****************************************************************************
+//  board_regmap.c
+//  I2C register map of the custom power board
+//
+//  The host reads and writes the board registers through the register map
+//  engine of the I2C slave driver. Register addresses are the REG_xxx
+//  definitions in board.h.
+//
+//  The status block (BoardStatusReg and the ADC result bytes) is served
+//  from a snapshot latched on address match, so the host always reads a
+//  coherent set of values. Call board_status_publish() after updating the
+//  status registers to make the new values visible to the host.
+//
+//  Host writes to REG_SHDN and REG_CHARGER go to a shadow copy and are
+//  applied together at the STOP of the write transaction, so a write of
+//  both registers never takes effect half way. A collision or bus error in
+//  the write transaction drops them, the Host Notify master's own bus
+//  errors do not. A write transaction with a NACKed byte is not applied
+//  at all, the host retries it. The functions run in the I2C ISR and are
+//  in board_regmap.h: board_regmap_init installs them as I2C callbacks,
+//  with I2C_0_STATIC_CALLBACKS i2c_slave_handlers.h inlines them.
+//
+//  Every applied control write and general call supply command is also put
+//  into a command ring for the main loop, which takes them with
+//  board_command_get() and runs the slow actions (supply sequencing,
+//  charger restart on CHARGER_RESTART) outside of the I2C ISR. The ISR
+//  never waits: a write that does not fit into the ring is NACKed, so the
+//  host knows to retry and no command is lost. A control write reserves
+//  its ring entry when it is ACKed, so the commit at STOP always fits.
+//
+//  REG_ADDRESS and REG_COMMAND change the I2C address, see board_address.c.
+//  REG_ADDRESS always reads the address the board answers on, a written
+//  address only takes effect with CMD_COMMIT_ADDRESS.
+//
+//  REG_STATS is the statistics block of the I2C slave driver, I2C_0_stats,
+//  latched at the start of a transaction, see STATS_xxx in board.h. Like
+//  every 16-bit value of the map, the counters are sent high byte first.
+//  REG_SNIFF is the log of the bus sniffer, started and stopped with the
+//  CMD_SNIFF_xxx commands, see board_sniff.c.
+//
+//  REG_INFO is a descriptor block the host reads once at start-up: the
+//  protocol version, a hash of the register layout, the optional features
+//  built in and the ADC thresholds, see INFO_xxx in board.h. A host that
+//  has seen the same version and hash before can skip probing.
+//
+//  REG_DIRTY has one bit per register REG_STATUS..REG_CHARGER that is set
+//  when the firmware changes the register and cleared once the host has
+//  read REG_DIRTY. A poller reads REG_DIRTY and fetches only what changed.
+//  Host writes do not mark registers dirty. With the snapshot, REG_DIRTY is
+//  latched together with the status block, so its bits match the status
+//  values read in the same transaction.
+//
+//  With I2C_0_ALERT_ENABLE, board_status_publish() also asserts SMBALERT#
+//  when one of the STATUS_ALERT_MASK flags changed, so the host does not
+//  need to poll REG_STATUS.
+//
+//  With I2C_0_HOST_NOTIFY_ENABLE, it sends BoardStatusReg to the host as an
+//  SMBus Host Notify message when AC12V is lost or a battery fault shows up.
+//
+//  Neither fires on the first call of board_status_publish(), which only
+//  takes the measured status as the starting point. board_regmap_init
+//  publishes the status block without it, before anything was measured.
+//
+****************************************************************************/
+
+#include <driver_init.h>
+#include "board_regmap.h"
+
+#if I2C_0_REGMAP_ENABLE
+
+// Commands from the I2C ISR to the main loop: REG_xxx and the value written
+cmd_ring_t boardCommands;
+
+#define STATUS_COUNT		(REG_V5_ADC_L - REG_STATUS + 1)
+
+// Change bitmap served as REG_DIRTY
+volatile uint8_t dirtyReg;
+
+#if I2C_0_SNAPSHOT_ENABLE
+// REG_DIRTY as latched with the status block, and as it was when latched.
+// The register map clears the bits the host read in dirtyLatch, they are
+// cleared in dirtyReg at STOP.
+volatile uint8_t dirtyLatch;
+uint8_t          dirtyLatched;
+
+#define DIRTY_REG			(&dirtyLatch)
+#else
+#define DIRTY_REG			(&dirtyReg)
+#endif
+
+// Status values of the previous publish, to find the changed registers
+static uint8_t statusLast[STATUS_COUNT];
+
+static void board_snapshot_publish(void);
+
+#if I2C_0_SNAPSHOT_ENABLE
+/****************************************************************************
+  Status block snapshot: two producer blocks, then the latched copy.
+  Each block starts with the SMBus byte count so that the latched copy can
+  also be read as the REG_STATUS_BLOCK block register.
+****************************************************************************/
+#define STATUS_BLOCK_SIZE	(1 + STATUS_COUNT)
+#define STATUS_LATCHED		(2 * STATUS_BLOCK_SIZE)
+
+static volatile uint8_t status_snapshot[3 * STATUS_BLOCK_SIZE];
+
+#define STATUS_REG(reg, var)	(&status_snapshot[STATUS_LATCHED + 1 + (reg) - REG_STATUS])
+#else
+#define STATUS_REG(reg, var)	(var)
+#endif
+
+/****************************************************************************
+  Control register shadows, indexed by register - REG_SHDN
+****************************************************************************/
+volatile uint8_t shadowReg[SHADOW_COUNT];
+uint8_t          shadowPending;
+
+#define CONTROL_REG(reg, var)	(&shadowReg[(reg) - REG_SHDN]), board_shadow_write
+
+/****************************************************************************
+  Address change: REG_ADDRESS reads the live address and stages a valid
+  written one in addressNew, REG_COMMAND queues CMD_COMMIT_ADDRESS for the
+  main loop.
+****************************************************************************/
+volatile uint8_t addressReg;
+uint8_t          addressNew;
+volatile uint8_t commandReg;
+
+#if I2C_0_STATS_ENABLE
+// REG_STATS, latched by board_shadow_begin
+volatile uint8_t statsReg[STATS_SIZE];
+#endif
+
+/****************************************************************************
+  REG_INFO descriptor, built by board_info_init
+****************************************************************************/
+static volatile uint8_t infoBlock[1 + INFO_SIZE];
+
+/****************************************************************************
+  Register table, sorted by address
+****************************************************************************/
+static const i2c_reg_t board_regs[] = {
+	{REG_STATUS, 1, I2C_REG_R, STATUS_REG(REG_STATUS, &BoardStatusReg.all), NULL},
+	{REG_VIN_ADC_H, 1, I2C_REG_R, STATUS_REG(REG_VIN_ADC_H, &vinAdcRegH), NULL},
+	{REG_VIN_ADC_L, 1, I2C_REG_R, STATUS_REG(REG_VIN_ADC_L, &vinAdcRegL), NULL},
+	{REG_V5_ADC_H, 1, I2C_REG_R, STATUS_REG(REG_V5_ADC_H, &v5AdcRegH), NULL},
+	{REG_V5_ADC_L, 1, I2C_REG_R, STATUS_REG(REG_V5_ADC_L, &v5AdcRegL), NULL},
+	{REG_SHDN, 1, I2C_REG_RW, CONTROL_REG(REG_SHDN, &shdnReg)},
+	{REG_CHARGER, 1, I2C_REG_RW, CONTROL_REG(REG_CHARGER, &chargerReg)},
+	{REG_DIRTY, 1, I2C_REG_R | I2C_REG_CLEAR, DIRTY_REG, NULL},
+	{REG_ADDRESS, 1, I2C_REG_RW, &addressReg, board_address_write},
+	{REG_COMMAND, 1, I2C_REG_W, &commandReg, board_command_write},
+#if I2C_0_SNAPSHOT_ENABLE
+	{REG_STATUS_BLOCK, STATUS_BLOCK_SIZE, I2C_REG_R | I2C_REG_BLOCK, &status_snapshot[STATUS_LATCHED], NULL},
+#endif
+#if I2C_0_STATS_ENABLE
+	{REG_STATS, sizeof(statsReg), I2C_REG_R, statsReg, NULL},
+#endif
+#if I2C_0_SNIFFER_ENABLE
+	{REG_SNIFF, sizeof(i2c_sniff_log_t), I2C_REG_R, (volatile uint8_t *)&I2C_0_sniff_log, NULL},
+#endif
+	{REG_INFO, sizeof(infoBlock), I2C_REG_R | I2C_REG_BLOCK, infoBlock, NULL},
+};
+
+// sizeof(i2c_sniff_log_t): head, count and 3 bytes per event
+#if I2C_0_SNIFFER_ENABLE && REG_SNIFF + 2 + 3 * I2C_0_SNIFFER_SIZE > REG_INFO
+#error "REG_SNIFF overlaps REG_INFO, lower I2C_0_SNIFFER_SIZE"
+#endif
+
+#if I2C_0_ADDRESS_MASK
+#if I2C_0_ADDRESS_MASK != 1 && I2C_0_ADDRESS_MASK != 3
+#error "board_regmap.c defines two or four register banks, I2C_0_ADDRESS_MASK must be 1 or 3"
+#endif
+
+/****************************************************************************
+  Virtual address banks. A plain read from offset 0 returns the whole bank,
+  so the host does not need a pointer write per poll.
+    I2C_0_ADDRESS ^ 0: status and control, the board_regs map
+    I2C_0_ADDRESS ^ 1: ADC stream, VIN then +5V, high byte first
+    I2C_0_ADDRESS ^ 2: configuration, shdnReg then chargerReg
+    I2C_0_ADDRESS ^ 3: status block as one SMBus block read
+  There is no event log on this board yet, bank 3 is the place for it.
+****************************************************************************/
+static const i2c_reg_t board_adc_regs[] = {
+	{0x00, 1, I2C_REG_R, STATUS_REG(REG_VIN_ADC_H, &vinAdcRegH), NULL},
+	{0x01, 1, I2C_REG_R, STATUS_REG(REG_VIN_ADC_L, &vinAdcRegL), NULL},
+	{0x02, 1, I2C_REG_R, STATUS_REG(REG_V5_ADC_H, &v5AdcRegH), NULL},
+	{0x03, 1, I2C_REG_R, STATUS_REG(REG_V5_ADC_L, &v5AdcRegL), NULL},
+};
+
+static const i2c_reg_t board_config_regs[] = {
+	{0x00, 1, I2C_REG_RW, CONTROL_REG(REG_SHDN, &shdnReg)},
+	{0x01, 1, I2C_REG_RW, CONTROL_REG(REG_CHARGER, &chargerReg)},
+};
+
+#if I2C_0_SNAPSHOT_ENABLE
+static const i2c_reg_t board_block_regs[] = {
+	{0x00, STATUS_BLOCK_SIZE, I2C_REG_R | I2C_REG_BLOCK, &status_snapshot[STATUS_LATCHED], NULL},
+};
+#else
+#define board_block_regs board_regs
+#endif
+
+#define BANK(regs) {regs, sizeof(regs) / sizeof(regs[0])}
+
+static const i2c_bank_t board_banks[I2C_0_ADDRESS_MASK + 1] = {
+	BANK(board_regs),
+	BANK(board_adc_regs),
+#if I2C_0_ADDRESS_MASK == 3
+	BANK(board_config_regs),
+	BANK(board_block_regs),
+#endif
+};
+#endif
+
+#if !I2C_0_STATIC_CALLBACKS
+/****************************************************************************
+  I2C callbacks, see board_regmap.h
+****************************************************************************/
+static void board_address_match(void)
+{
+	board_shadow_begin(I2C_0_is_repeated_start());
+}
+#endif
+
+/****************************************************************************
+  Fill in the REG_INFO descriptor
+****************************************************************************/
+static void board_info_word(uint8_t offset, uint16_t value)
+{
+	infoBlock[1 + offset]     = value >> 8;
+	infoBlock[1 + offset + 1] = value;
+}
+
+static void board_info_init(void)
+{
+	uint8_t sum1 = 0, sum2 = 0;
+#if I2C_0_ADDRESS_MASK
+	const i2c_bank_t *bank = board_banks;
+	const i2c_bank_t *end  = board_banks + I2C_0_ADDRESS_MASK + 1;
+#else
+	const i2c_bank_t  banks[] = {{board_regs, sizeof(board_regs) / sizeof(board_regs[0])}};
+	const i2c_bank_t *bank    = banks;
+	const i2c_bank_t *end     = banks + 1;
+#endif
+
+	// Fletcher-16 of the register layout
+	for (; bank != end; bank++) {
+		for (uint8_t i = 0; i < bank->count; i++) {
+			const uint8_t layout[] = {bank->table[i].addr, bank->table[i].width, bank->table[i].flags};
+
+			for (uint8_t j = 0; j < sizeof(layout); j++) {
+				sum1 = (sum1 + layout[j]) % 255;
+				sum2 = (sum2 + sum1) % 255;
+			}
+		}
+	}
+
+	infoBlock[0]                 = INFO_SIZE;
+	infoBlock[1 + INFO_VERSION]  = INFO_PROTOCOL_VERSION;
+	board_info_word(INFO_LAYOUT_H, sum2 << 8 | sum1);
+	infoBlock[1 + INFO_FEATURES] = (I2C_0_PEC_ENABLE ? INFO_HAS_PEC : 0)
+	                               | (I2C_0_SNAPSHOT_ENABLE ? INFO_HAS_BLOCK : 0)
+	                               | (I2C_0_ALERT_ENABLE ? INFO_HAS_ALERT : 0)
+	                               | (I2C_0_HOST_NOTIFY_ENABLE ? INFO_HAS_NOTIFY : 0)
+	                               | (I2C_0_ARP_ENABLE ? INFO_HAS_ARP : 0)
+	                               | (I2C_0_STATS_ENABLE ? INFO_HAS_STATS : 0)
+	                               | (I2C_0_SNIFFER_ENABLE ? INFO_HAS_SNIFF : 0);
+	infoBlock[1 + INFO_ADDRESS_MASK] = I2C_0_ADDRESS_MASK;
+	infoBlock[1 + INFO_ADC_BITS]     = ADC_0_get_resolution();
+	board_info_word(INFO_MIN_12V, MIN_12V);
+	board_info_word(INFO_MAX_12V, MAX_12V);
+	board_info_word(INFO_MIN_5VIN, MIN_5VIN);
+	board_info_word(INFO_MAX_5VIN, MAX_5VIN);
+	board_info_word(INFO_MAX_GND, MAX_GND);
+}
+
+/****************************************************************************
+  Install the register map, call before enabling interrupts
+****************************************************************************/
+void board_regmap_init(void)
+{
+	addressReg = board_address();
+	I2C_0_set_address(addressReg);
+	board_info_init();
+#if I2C_0_SNAPSHOT_ENABLE
+	I2C_0_snapshot_init(status_snapshot, STATUS_BLOCK_SIZE);
+	board_snapshot_publish();
+	I2C_0_snapshot_latch();
+#endif
+#if I2C_0_ADDRESS_MASK
+	I2C_0_regmap_init_banks(board_banks);
+#else
+	I2C_0_regmap_init(board_regs, sizeof(board_regs) / sizeof(board_regs[0]));
+#endif
+#if !I2C_0_STATIC_CALLBACKS
+	I2C_0_set_address_callback(board_address_match);
+	I2C_0_set_stop_callback(board_shadow_commit);
+	I2C_0_set_collision_callback(board_shadow_drop);
+	I2C_0_set_bus_error_callback(board_shadow_drop);
+#if I2C_0_GENERAL_CALL_ENABLE
+	I2C_0_set_general_call_callback(board_general_call);
+#endif
+#endif
+}
+
+/****************************************************************************
+  Take the next command for the main loop. reg is REG_SHDN or REG_CHARGER
+  and value the value written, e.g. RESET_SUPPLY or CHARGER_RESTART.
+  REG_COMMAND commands are carried out here before they are returned.
+  Returns false when there is nothing to do.
+****************************************************************************/
+bool board_command_get(uint8_t *reg, uint8_t *value)
+{
+	if (!cmd_ring_get(&boardCommands, reg, value)) {
+		return false;
+	}
+	if (*reg == REG_COMMAND) {
+		switch (*value) {
+		case CMD_COMMIT_ADDRESS:
+			board_address_commit(addressNew);
+			break;
+#if I2C_0_SNIFFER_ENABLE
+		case CMD_SNIFF_START:
+			I2C_0_sniffer_start();
+			break;
+		case CMD_SNIFF_STOP:
+			I2C_0_sniffer_stop();
+			break;
+		case CMD_SNIFF_DUMP:
+			board_sniff_dump();
+			break;
+#endif
+		}
+	}
+	return true;
+}
+
+/****************************************************************************
+  Flag a register as changed for the host, e.g. after the firmware updated
+  shdnReg or chargerReg. The status registers are flagged by
+  board_status_publish. A race with the host reading REG_DIRTY can only
+  leave a bit set twice, never lose one.
+****************************************************************************/
+void board_mark_dirty(uint8_t reg)
+{
+	dirtyReg |= 1 << (reg - REG_STATUS);
+}
+
+/****************************************************************************
+  Flag the changed status registers in REG_DIRTY and publish the status
+  block to the snapshot
+****************************************************************************/
+static void board_snapshot_publish(void)
+{
+	uint8_t status[STATUS_COUNT] = {BoardStatusReg.all, vinAdcRegH, vinAdcRegL, v5AdcRegH, v5AdcRegL};
+	uint8_t changed              = 0;
+
+	for (uint8_t i = 0; i < STATUS_COUNT; i++) {
+		if (status[i] != statusLast[i]) {
+			statusLast[i] = status[i];
+			changed |= 1 << i;
+		}
+	}
+	dirtyReg |= changed;
+
+#if I2C_0_SNAPSHOT_ENABLE
+	volatile uint8_t *block = I2C_0_snapshot_begin();
+
+	block[0] = STATUS_COUNT;
+	for (uint8_t i = 0; i < STATUS_COUNT; i++) {
+		block[1 + i] = status[i];
+	}
+	I2C_0_snapshot_publish();
+#endif
+}
+
+/****************************************************************************
+  Publish the status registers to the host.
+  Call from the context that updates BoardStatusReg and the ADC result
+  bytes, once they are all up to date. No critical section is needed.
+  The first call only takes the alert and notify state.
+****************************************************************************/
+void board_status_publish(void)
+{
+#if I2C_0_ALERT_ENABLE || I2C_0_HOST_NOTIFY_ENABLE
+	static bool seeded;
+#endif
+#if I2C_0_ALERT_ENABLE
+	static uint8_t alertStatus;
+	uint8_t        alert_bits = BoardStatusReg.all & STATUS_ALERT_MASK;
+
+	if (alert_bits != alertStatus) {
+		alertStatus = alert_bits;
+		if (seeded) {
+			I2C_0_alert_assert();
+		}
+	}
+#endif
+#if I2C_0_HOST_NOTIFY_ENABLE
+	static uint8_t notifyFaults;
+	uint8_t        faults = (BoardStatusReg.ac12vStatus ^ 1) | BoardStatusReg.batteryFault << 1;
+
+	// Notify on new faults only, try again on the next publish if busy
+	if (!seeded || !(faults & ~notifyFaults) || I2C_0_host_notify(BoardStatusReg.all)) {
+		notifyFaults = faults;
+	}
+#endif
+#if I2C_0_ALERT_ENABLE || I2C_0_HOST_NOTIFY_ENABLE
+	seeded = true;
+#endif
+	board_snapshot_publish();
+}
+
+#endif
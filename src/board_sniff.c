@@ -0,0 +1,105 @@
+/****************************************************************************
+//  board_sniff.c
+//  I2C bus sniffer log output on the debug pin
+//
+//  CMD_SNIFF_DUMP stops the sniffer of the I2C slave driver and prints its
+//  log on debug_PB3 as 9600 baud 8N1 serial, oldest event first, one line
+//  per event:
+//    tttt aa
+//  with the TCA0 timestamp tttt and the address byte aa (R/W bit
+//  included) of a START, or FF for a STOP, both in hex. A USB serial
+//  adapter on PB3 is enough to read it on the production floor. The same
+//  log can be read over I2C from REG_SNIFF.
+//
+//  Interrupts stay on while sending, so the I2C slave is served during a
+//  dump. Every bit edge is timed against the free running TCB0 from the
+//  start bit of its character, so an interrupt only delays the edge it
+//  falls on, and the delays do not add up over the character. An edge
+//  that is late by less than half a bit (52 us) is still sampled right by
+//  the receiver; an interrupt handler running longer than that garbles
+//  the character it falls into. TCB0 is only used here, while dumping.
+//
+****************************************************************************/
+
+#include <driver_init.h>
+#include <atomic.h>
+#include "board.h"
+
+#if I2C_0_SNIFFER_ENABLE
+
+#define SNIFF_BAUD		9600
+#define SNIFF_BIT_TICKS	(F_CPU / SNIFF_BAUD)	// TCB0 counts the system clock
+
+/****************************************************************************
+  Send bits of frame LSB first, one bit time each, timed from the first
+****************************************************************************/
+static void board_sniff_bits(uint16_t frame, uint8_t bits)
+{
+	uint16_t edge = TCB0.CNT;
+
+	while (bits--) {
+		debug_PB3_set_level(frame & 1);
+		frame >>= 1;
+		edge += SNIFF_BIT_TICKS;
+		while ((int16_t)(TCB0.CNT - edge) < 0)
+			;
+	}
+}
+
+/****************************************************************************
+  Send one character: start bit, 8 data bits, stop bit
+****************************************************************************/
+static void board_sniff_putc(uint8_t c)
+{
+	board_sniff_bits((uint16_t)c << 1 | 1 << 9, 10);
+}
+
+static void board_sniff_hex(uint8_t value)
+{
+	static const char digits[] = "0123456789ABCDEF";
+
+	board_sniff_putc(digits[value >> 4]);
+	board_sniff_putc(digits[value & 0x0f]);
+}
+
+/****************************************************************************
+  Stop the sniffer and print its log. Called from the main loop, blocks
+  for about 10 ms per event.
+****************************************************************************/
+void board_sniff_dump(void)
+{
+	uint8_t count;
+	uint8_t index;
+
+	I2C_0_sniffer_stop();
+	count = I2C_0_sniff_log.count;
+	index = (uint8_t)(I2C_0_sniff_log.head - count) & (I2C_0_SNIFFER_SIZE - 1);
+
+	// Free running over the whole 16 bits, no interrupt
+	TCB0.CCMP  = 0xffff;
+	TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+	TCB0.CTRLA = TCB_CLKSEL_CLKDIV1_gc | TCB_ENABLE_bm;
+
+	// debug_PB3 idles low, hold the line high for a frame before the first start bit
+	board_sniff_bits(0x3ff, 10);
+	while (count--) {
+		i2c_sniff_t event;
+
+		// Copy the entry out, only the sending runs with interrupts on
+		ENTER_CRITICAL(D);
+		event = I2C_0_sniff_log.event[index];
+		EXIT_CRITICAL(D);
+
+		board_sniff_hex(event.time[0]);
+		board_sniff_hex(event.time[1]);
+		board_sniff_putc(' ');
+		board_sniff_hex(event.event);
+		board_sniff_putc('\r');
+		board_sniff_putc('\n');
+		index = (index + 1) & (I2C_0_SNIFFER_SIZE - 1);
+	}
+	debug_PB3_set_level(false);
+	TCB0.CTRLA = 0;
+}
+
+#endif
@@ -38,6 +38,38 @@
 #include <cpuint.h>
 #include <ccp.h>
 #include <atomic.h>
+
+/*
+ * Shared state with the TWI slave vector at level 1 (CPUINT_LVL1VEC)
+ *
+ * ISR(TWI0_TWIS_vect) then also interrupts the ADC, TCA0 and TWI master
+ * handlers. cli() and ENTER_CRITICAL still block it. What it shares:
+ *
+ * - TCA0 TEMP: the statistics and the sniffer read TCA0.SINGLE.CNT. The
+ *   vector saves and restores TEMP, so a 16-bit CNT access it interrupts,
+ *   e.g. TIMER_0_set_timer_duration in ISR(TCA0_OVF_vect), stays intact.
+ * - Timeout list: not touched from the vector. I2C_0_bus_check runs from
+ *   TIMER_0_timeout_call_next_callback in the main loop, and the sniffer
+ *   only starts and stops from there. Never call TIMER_0_timeout_* from
+ *   an I2C callback.
+ * - ADC callback: ADC_0_cb and the ADC registers are not touched from the
+ *   vector. What the callback passes on reaches the I2C registers through
+ *   board_status_publish: the status snapshot is lock-free for one
+ *   producer, and REG_DIRTY updates can only set a bit twice, whether
+ *   the producer is the main loop or a level 0 handler.
+ * - Command ring: produced in the vector, taken in the main loop. The
+ *   bus stuck check also gives back reserved entries, see below.
+ * - I2C_0_stats: also counted by ISR(TWI0_TWIM_vect), which calls the
+ *   notify error callback too, both in a critical section.
+ * - Slave callbacks: called from the vector, and from I2C_0_bus_check in
+ *   the main loop, which drops a stuck transaction with
+ *   I2C_0_data_abort and I2C_0_bus_error_callback (board_shadow_drop,
+ *   the ring release). It does so inside ENTER_CRITICAL, so the vector
+ *   cannot run in between and the callbacks never run twice at once.
+ * - Single-byte flags and registers (I2C_0_bus_idle, shdnReg, chargerReg,
+ *   TWI0.SADDR, ...) are read and written atomically.
+ */
+
 /**
  * \brief Initialize cpuint interface
  *
@@ -54,7 +86,9 @@ int8_t CPUINT_init()
 
 	// CPUINT.LVL0PRI = 0x0 << CPUINT_LVL0PRI_gp; /* Interrupt Level Priority: 0x0 */
 
-	// CPUINT.LVL1VEC = 0x0 << CPUINT_LVL1VEC_gp; /* Interrupt Vector with High Priority: 0x0 */
+#if CPUINT_LVL1VEC
+	CPUINT.LVL1VEC = CPUINT_LVL1VEC << CPUINT_LVL1VEC_gp; /* Interrupt Vector with High Priority: CPUINT_LVL1VEC */
+#endif
 
 	return 0;
 }
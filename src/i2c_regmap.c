@@ -0,0 +1,85 @@
+/**
+ * \file
+ *
+ * \brief I2C slave register map engine.
+ *
+ */
+
+/**
+ * \defgroup doc_driver_i2c_regmap I2C Slave Register Map
+ * \ingroup doc_driver_i2c
+ *
+ * \section doc_driver_i2c_regmap_rev Revision History
+ * - v0.0.0.1 Initial Commit
+ *
+ *@{
+ */
+
+#include <i2c_regmap.h>
+
+i2c_regmap_t I2C_0_regmap;
+
+#if I2C_0_SNAPSHOT_ENABLE
+i2c_snapshot_t I2C_0_snapshot;
+#endif
+
+/**
+ * \brief Install the register table served by the I2C slave
+ *
+ * The table is normally declared const so that it stays in the memory
+ * mapped flash and costs no RAM.
+ *
+ * \param[in] table Register table, sorted by ascending address, must not overlap
+ * \param[in] count Number of entries in the table
+ *
+ * \return Nothing
+ */
+void I2C_0_regmap_init(const i2c_reg_t *table, uint8_t count)
+{
+	I2C_0_regmap.table   = table;
+	I2C_0_regmap.end     = table + count;
+	I2C_0_regmap.set_ptr = false;
+	I2C_0_regmap.nacked  = false;
+	I2C_0_regmap.clear   = NULL;
+#if I2C_0_PREFETCH_ENABLE
+	I2C_0_regmap.prefetched = false;
+	I2C_0_regmap.next_clear = NULL;
+#endif
+#if I2C_0_ADDRESS_MASK
+	I2C_0_regmap.banks = NULL;
+#endif
+	I2C_0_regmap_seek(0);
+}
+
+#if I2C_0_ADDRESS_MASK
+/**
+ * \brief Install one register table per virtual slave address
+ *
+ * \param[in] banks I2C_0_ADDRESS_MASK + 1 banks, normally const
+ *
+ * \return Nothing
+ */
+void I2C_0_regmap_init_banks(const i2c_bank_t *banks)
+{
+	I2C_0_regmap_init(banks[0].table, banks[0].count);
+	I2C_0_regmap.banks = banks;
+}
+#endif
+
+#if I2C_0_SNAPSHOT_ENABLE
+/**
+ * \brief Install the snapshot block
+ *
+ * \param[in] buf  Storage for three blocks of size bytes
+ * \param[in] size Size of the block
+ *
+ * \return Nothing
+ */
+void I2C_0_snapshot_init(volatile uint8_t *buf, uint8_t size)
+{
+	I2C_0_snapshot.buf    = buf;
+	I2C_0_snapshot.size   = size;
+	I2C_0_snapshot.front  = 0;
+	I2C_0_snapshot.frozen = 0;
+}
+#endif
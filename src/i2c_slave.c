@@ -36,9 +36,52 @@
  */
 
 #include <i2c_slave.h>
+#include <i2c_slave_config.h>
 #include <driver_init.h>
 #include <stdbool.h>
+#include <atomic.h>
+#if I2C_0_REGMAP_ENABLE
+#include <i2c_regmap.h>
+#endif
+#if I2C_0_ARP_ENABLE
+#include <smbus_arp.h>
+#endif
 
+#if I2C_0_REGMAP_ENABLE && I2C_0_BUFFER_ENABLE
+#error "I2C_0_REGMAP_ENABLE and I2C_0_BUFFER_ENABLE are mutually exclusive"
+#endif
+
+#if I2C_0_FMPLUS_ENABLE && F_CPU / I2C_0_ISR_CYCLES < 1000000 / 9
+#warning "F_CPU is too slow to serve Fm+ bytes without stretching SCL, raise the clock in CLKCTRL_init"
+#endif
+
+#if I2C_0_PREFETCH_ENABLE && !I2C_0_REGMAP_ENABLE
+#error "I2C_0_PREFETCH_ENABLE needs I2C_0_REGMAP_ENABLE"
+#endif
+
+#if I2C_0_FAST_PATH_ENABLE
+#if !I2C_0_BUFFER_ENABLE
+#error "I2C_0_FAST_PATH_ENABLE needs I2C_0_BUFFER_ENABLE"
+#endif
+#if I2C_0_STATS_ENABLE || I2C_0_ALERT_ENABLE || I2C_0_ARP_ENABLE
+#error "I2C_0_FAST_PATH_ENABLE cannot be used with I2C_0_STATS_ENABLE, I2C_0_ALERT_ENABLE or I2C_0_ARP_ENABLE"
+#endif
+
+// Shared with i2c_slave_fast.S
+#define I2C_0_ASM_SHARED
+
+// Called by ISR(TWI0_TWIS_vect) in i2c_slave_fast.S for everything but a
+// read data byte, with the call-clobbered registers saved
+#define I2C_0_VECT __attribute__((flatten)) void I2C_0_vect(void)
+void I2C_0_vect(void);
+#else
+#define I2C_0_ASM_SHARED static
+// Flattened: the static inline helpers are inlined even at -Os, a single
+// call left in the vector makes it save every call-clobbered register
+#define I2C_0_VECT ISR(TWI0_TWIS_vect, __attribute__((flatten)))
+#endif
+
+#if !I2C_0_STATIC_CALLBACKS
 // Read Event Interrupt Handlers
 void I2C_0_read_callback(void);
 void (*I2C_0_read_interrupt_handler)(void);
@@ -63,6 +106,287 @@ void (*I2C_0_collision_interrupt_handler)(void);
 void I2C_0_bus_error_callback(void);
 void (*I2C_0_bus_error_interrupt_handler)(void);
 
+#if I2C_0_GENERAL_CALL_ENABLE
+// General Call Command Interrupt Handlers
+bool I2C_0_general_call_callback(uint8_t command);
+bool (*I2C_0_general_call_interrupt_handler)(uint8_t command);
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+// Host Notify Error Interrupt Handlers
+void I2C_0_notify_error_callback(void);
+void (*I2C_0_notify_error_interrupt_handler)(void);
+#endif
+
+#if I2C_0_BUFFER_ENABLE
+// Transfer Complete Interrupt Handlers
+static i2c_transfer_callback *I2C_0_transfer_interrupt_handler;
+#endif
+#endif
+
+// Set on address match, cleared on STOP: an address match while set is a repeated START
+static bool I2C_0_addressed;
+
+#if I2C_0_STATIC_CALLBACKS
+// Event handlers are static inline functions bound at compile time, after
+// the driver state they may look at
+#include <i2c_slave_handlers.h>
+#endif
+
+#if I2C_0_GENERAL_CALL_ENABLE
+// Set while the slave is addressed by a general call
+static bool I2C_0_general_call;
+#endif
+
+#if I2C_0_ALERT_ENABLE
+#if I2C_0_ADDRESS_MASK
+#error "I2C_0_ALERT_ENABLE needs the second address match, it cannot be used with I2C_0_ADDRESS_MASK"
+#endif
+
+// Set while answering the Alert Response Address
+static bool I2C_0_ara;
+
+// Release SMBALERT# and stop answering the Alert Response Address
+static inline void I2C_0_alert_off(void)
+{
+	I2C_0_ALERT_PORT.DIRCLR = 1 << I2C_0_ALERT_PIN;
+	TWI0.SADDRMASK          = (TWI0.SADDR & TWI_ADDRMASK_gm) | 1 << TWI_ADDREN_bp;
+}
+#endif
+
+#if I2C_0_ARP_ENABLE
+#if I2C_0_ADDRESS_MASK || I2C_0_ALERT_ENABLE
+#error "I2C_0_ARP_ENABLE needs the second address match, it cannot be used with I2C_0_ADDRESS_MASK or I2C_0_ALERT_ENABLE"
+#endif
+
+// Set while addressed on the SMBus Device Default Address
+static bool I2C_0_arp_active;
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+// Master baud rate, rise time neglected
+#define I2C_0_MASTER_BAUD ((F_CPU / (2 * I2C_0_MASTER_FREQUENCY)) - 5)
+
+#define I2C_0_NOTIFY_IDLE 0xff
+
+// Host Notify message after the host address: our address, data low, data high
+static uint8_t          I2C_0_notify_msg[3];
+static volatile uint8_t I2C_0_notify_index = I2C_0_NOTIFY_IDLE;
+static uint8_t          I2C_0_notify_retries;
+#endif
+
+#if I2C_0_BUS_TIMEOUT_ENABLE
+// Bus checks per timeout, in timer ticks of the system clock per check
+#define I2C_0_BUS_CHECKS (I2C_0_BUS_TIMEOUT_MS / I2C_0_BUS_CHECK_MS)
+#define I2C_0_BUS_CHECK_TICKS ((absolutetime_t)(F_CPU / 1000) * I2C_0_BUS_CHECK_MS)
+
+static absolutetime_t I2C_0_bus_check(void *payload);
+
+static timer_struct_t   I2C_0_bus_timer = {I2C_0_bus_check};
+I2C_0_ASM_SHARED volatile uint8_t I2C_0_bus_idle; // Checks without bus activity while addressed
+static uint8_t          I2C_0_bus_timeouts; // Recoveries since reset, saturating
+#endif
+
+#if I2C_0_STATS_ENABLE
+i2c_stats_t I2C_0_stats;
+
+// Bytes and longest interrupt of the running transaction, added to
+// I2C_0_stats when it ends so no counter changes while the master reads it
+static uint16_t I2C_0_bytes_read;
+static uint16_t I2C_0_bytes_written;
+static uint16_t I2C_0_stretch;
+
+#define I2C_0_STATS_COUNT(counter) ((counter)++)
+
+static inline void I2C_0_stats_start(void)
+{
+	if (!I2C_0_addressed) {
+		I2C_0_stats.transactions++;
+	}
+}
+
+static inline void I2C_0_stats_end(void)
+{
+	I2C_0_stats.bytes_read += I2C_0_bytes_read;
+	I2C_0_stats.bytes_written += I2C_0_bytes_written;
+	if (I2C_0_stretch > I2C_0_stats.stretch_max) {
+		I2C_0_stats.stretch_max = I2C_0_stretch;
+	}
+	I2C_0_bytes_read    = 0;
+	I2C_0_bytes_written = 0;
+	I2C_0_stretch       = 0;
+}
+#else
+#define I2C_0_STATS_COUNT(counter)
+
+static inline void I2C_0_stats_start(void)
+{
+}
+
+static inline void I2C_0_stats_end(void)
+{
+}
+#endif
+
+#if I2C_0_SNIFFER_ENABLE
+#if I2C_0_SNIFFER_SIZE & (I2C_0_SNIFFER_SIZE - 1)
+#error "I2C_0_SNIFFER_SIZE must be a power of two"
+#endif
+
+i2c_sniff_log_t I2C_0_sniff_log;
+
+// Set while promiscuous mode is on
+static volatile bool I2C_0_sniffing;
+
+static inline void I2C_0_sniff_log_event(uint8_t event)
+{
+	uint8_t head = I2C_0_sniff_log.head;
+
+	uint16_t time = TCA0.SINGLE.CNT;
+
+	I2C_0_sniff_log.event[head].time[0] = time >> 8;
+	I2C_0_sniff_log.event[head].time[1] = time;
+	I2C_0_sniff_log.event[head].event   = event;
+	I2C_0_sniff_log.head              = (head + 1) & (I2C_0_SNIFFER_SIZE - 1);
+	if (I2C_0_sniff_log.count != I2C_0_SNIFFER_SIZE) {
+		I2C_0_sniff_log.count++;
+	}
+}
+
+// Whether the slave would match addr outside of promiscuous mode
+static inline bool I2C_0_own_address(uint8_t addr)
+{
+	uint8_t mask = TWI0.SADDRMASK;
+
+	if (!(addr & TWI_ADDRMASK_gm)) {
+		// General call, the enable bit of SADDR
+		return TWI0.SADDR & TWI_ADDREN_bm;
+	}
+	if (mask & TWI_ADDREN_bm) {
+		// Second address
+		return !((addr ^ TWI0.SADDR) & TWI_ADDRMASK_gm) || !((addr ^ mask) & TWI_ADDRMASK_gm);
+	}
+	return !((addr ^ TWI0.SADDR) & ~mask & TWI_ADDRMASK_gm);
+}
+#endif
+
+#if I2C_0_BUFFER_ENABLE
+// Transaction buffers
+I2C_0_ASM_SHARED i2c_buffer_t I2C_0_buffer;
+
+#if I2C_0_FAST_PATH_ENABLE && defined(__AVR__)
+#include <stddef.h>
+
+_Static_assert(offsetof(i2c_buffer_t, tx) == 0 && offsetof(i2c_buffer_t, tx_size) == 4
+                   && offsetof(i2c_buffer_t, tx_count) == 6,
+               "i2c_buffer_t layout does not match i2c_slave_fast.S");
+#endif
+#endif
+
+#if I2C_0_REGMAP_ENABLE
+// Data bytes are served from the register map, not the read/write callbacks
+#if I2C_0_PREFETCH_ENABLE
+static inline void I2C_0_data_read(void)
+{
+	// Release SCL first, fetch the following byte while this one is sent
+	TWI0.SDATA  = I2C_0_regmap_next();
+	TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+	I2C_0_regmap_prefetch();
+}
+#else
+static inline void I2C_0_data_read(void)
+{
+	TWI0.SDATA  = I2C_0_regmap_read();
+	TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+}
+#endif
+
+static inline void I2C_0_data_write(void)
+{
+	if (I2C_0_regmap_write(TWI0.SDATA)) {
+		TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+	} else {
+		TWI0.SCTRLB = TWI_ACKACT_NACK_gc | TWI_SCMD_COMPTRANS_gc;
+	}
+}
+
+static inline void I2C_0_data_stop(void)
+{
+	I2C_0_regmap_stop();
+}
+
+static inline void I2C_0_data_abort(void)
+{
+	I2C_0_regmap_abort();
+}
+#elif I2C_0_BUFFER_ENABLE
+// Data bytes are indexed straight out of the transaction buffers
+static inline void I2C_0_data_read(void)
+{
+	uint8_t data = I2C_0_REGMAP_FILL;
+
+	if (I2C_0_buffer.tx_count < I2C_0_buffer.tx_size) {
+		data = I2C_0_buffer.tx[I2C_0_buffer.tx_count++];
+	}
+	TWI0.SDATA  = data;
+	TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+}
+
+static inline void I2C_0_data_write(void)
+{
+	if (I2C_0_buffer.rx_count < I2C_0_buffer.rx_size) {
+		I2C_0_buffer.rx[I2C_0_buffer.rx_count++] = TWI0.SDATA;
+		TWI0.SCTRLB                              = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+	} else {
+		// RX buffer full
+		TWI0.SCTRLB = TWI_ACKACT_NACK_gc | TWI_SCMD_COMPTRANS_gc;
+	}
+}
+
+static inline void I2C_0_data_stop(void)
+{
+	uint8_t rx_count = I2C_0_buffer.rx_count;
+	uint8_t tx_count = I2C_0_buffer.tx_count;
+
+	I2C_0_buffer.rx_count = 0;
+	I2C_0_buffer.tx_count = 0;
+#if I2C_0_STATIC_CALLBACKS
+	I2C_0_transfer_callback(rx_count, tx_count);
+#else
+	if (I2C_0_transfer_interrupt_handler) {
+		I2C_0_transfer_interrupt_handler(rx_count, tx_count);
+	}
+#endif
+}
+
+static inline void I2C_0_data_abort(void)
+{
+	I2C_0_buffer.rx_count = 0;
+	I2C_0_buffer.tx_count = 0;
+}
+#else
+static inline void I2C_0_data_read(void)
+{
+	I2C_0_read_callback();
+	TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+}
+
+static inline void I2C_0_data_write(void)
+{
+	I2C_0_write_callback();
+}
+#endif
+
+#if !I2C_0_REGMAP_ENABLE && !I2C_0_BUFFER_ENABLE
+static inline void I2C_0_data_stop(void)
+{
+}
+
+static inline void I2C_0_data_abort(void)
+{
+}
+#endif
+
 /**
  * \brief Initialize I2C interface
  * If module is configured to disabled state, the clock to the I2C is disabled
@@ -73,31 +397,76 @@ void (*I2C_0_bus_error_interrupt_handler)(void);
 void I2C_0_init()
 {
 
-	// TWI0.CTRLA = 0 << TWI_FMPEN_bp /* FM Plus Enable: disabled */
-	//		 | TWI_SDAHOLD_OFF_gc /* SDA hold time off */
-	//		 | TWI_SDASETUP_4CYC_gc; /* SDA setup time is 4 clock cycles */
+	TWI0.CTRLA = I2C_0_FMPLUS_ENABLE << TWI_FMPEN_bp             /* FM Plus Enable: I2C_0_FMPLUS_ENABLE */
+	             | I2C_0_SDA_HOLD << TWI_SDAHOLD_gp            /* SDA hold time: I2C_0_SDA_HOLD */
+	             | I2C_0_SDA_SETUP << TWI_SDASETUP_bp;         /* SDA setup time: I2C_0_SDA_SETUP */
 
 	TWI0.DBGCTRL = 1 << TWI_DBGRUN_bp; /* Debug Run: enabled */
 
-	TWI0.SADDR = 0x3e << TWI_ADDRMASK_gp /* Slave Address: 0x3e */
-	             | 0 << TWI_ADDREN_bp;   /* General Call Recognition Enable: disabled */
+	TWI0.SADDR = I2C_0_ADDRESS << TWI_ADDRMASK_gp                  /* Slave Address: I2C_0_ADDRESS */
+	             | I2C_0_GENERAL_CALL_ENABLE << TWI_ADDREN_bp; /* General Call Recognition Enable */
+
+#if I2C_0_ADDRESS_MASK
+	TWI0.SADDRMASK = 0 << TWI_ADDREN_bp                        /* Address Mask Enable: disabled, mask mode */
+	                 | I2C_0_ADDRESS_MASK << TWI_ADDRMASK_gp; /* Address Mask: don't care bits */
+#elif I2C_0_ARP_ENABLE
+	TWI0.SADDRMASK = 1 << TWI_ADDREN_bp                       /* Address Mask Enable: enabled, second address */
+	                 | SMBUS_ARP_ADDRESS << TWI_ADDRMASK_gp; /* Address Mask: SMBus Device Default Address */
 
-	TWI0.SADDRMASK = 1 << TWI_ADDREN_bp         /* Address Mask Enable: enabled */
-	                 | 0x3e << TWI_ADDRMASK_gp; /* Address Mask: 0x3e */
+	I2C_0_arp_init();
+#else
+	TWI0.SADDRMASK = 1 << TWI_ADDREN_bp                   /* Address Mask Enable: enabled, second address */
+	                 | I2C_0_ADDRESS << TWI_ADDRMASK_gp; /* Address Mask: I2C_0_ADDRESS */
+#endif
+
+#if I2C_0_ALERT_ENABLE
+	/* SMBALERT# is open drain: output low when asserted, input when released */
+	I2C_0_ALERT_PORT.OUTCLR = 1 << I2C_0_ALERT_PIN;
+	I2C_0_ALERT_PORT.DIRCLR = 1 << I2C_0_ALERT_PIN;
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+	TWI0.MBAUD = I2C_0_MASTER_BAUD; /* Master Baud Rate: I2C_0_MASTER_FREQUENCY */
+
+	TWI0.MCTRLA = 1 << TWI_ENABLE_bp     /* Enable TWI Master: enabled */
+	              | TWI_WIEN_bm          /* Write Interrupt Enable: enabled */
+	              | TWI_TIMEOUT_200US_gc; /* Bus Timeout: 200us, unknown bus state goes idle */
+
+	TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc; /* Force the bus state machine to idle */
+#endif
 
 	TWI0.SCTRLA = 1 << TWI_APIEN_bp    /* Address/Stop Interrupt Enable: enabled */
 	              | 1 << TWI_DIEN_bp   /* Data Interrupt Enable: enabled */
 	              | 1 << TWI_ENABLE_bp /* Enable TWI Slave: enabled */
-	              | 0 << TWI_PIEN_bp   /* Stop Interrupt Enable: disabled */
+	              | 1 << TWI_PIEN_bp   /* Stop Interrupt Enable: enabled */
 	              | 0 << TWI_PMEN_bp   /* Promiscuous Mode Enable: disabled */
 	              | 1 << TWI_SMEN_bp;  /* Smart Mode Enable: enabled */
 
+#if I2C_0_BUS_TIMEOUT_ENABLE
+	TIMER_0_timeout_delete(&I2C_0_bus_timer);
+	TIMER_0_timeout_create(&I2C_0_bus_timer, I2C_0_BUS_CHECK_TICKS);
+#endif
+
+#if !I2C_0_STATIC_CALLBACKS
 	I2C_0_set_write_callback(NULL);
 	I2C_0_set_read_callback(NULL);
 	I2C_0_set_address_callback(NULL);
 	I2C_0_set_stop_callback(NULL);
 	I2C_0_set_collision_callback(NULL);
 	I2C_0_set_bus_error_callback(NULL);
+#if I2C_0_GENERAL_CALL_ENABLE
+	I2C_0_set_general_call_callback(NULL);
+#endif
+#if I2C_0_HOST_NOTIFY_ENABLE
+	I2C_0_set_notify_error_callback(NULL);
+#endif
+#if I2C_0_BUFFER_ENABLE
+	I2C_0_set_transfer_callback(NULL);
+#endif
+#endif
+#if I2C_0_BUFFER_ENABLE
+	I2C_0_set_buffers(NULL, 0, NULL, 0);
+#endif
 }
 
 /**
@@ -124,60 +493,628 @@ void I2C_0_close(void)
  * \brief The function called by the I2C IRQ handler.
  * Can be called in a polling loop in a polled driver.
  *
+ * SSTATUS is sampled once and the event is decoded by a single switch on
+ * the interrupt flags, direction and address/stop bits. The cases are
+ * ordered by how often they occur. COLL and BUSERR are part of the switch
+ * key, so any error status falls through to the default case and takes
+ * precedence over the data and address events, as before. With DIF and
+ * APIF both set an address match is served first, then a data byte, and
+ * a STOP waits for the next interrupt. An error clears the flags it came
+ * with and ends the transaction, so the interrupt cannot fire again and
+ * again.
+ *
+ * Always inlined: the TWI vectors use it directly, so that with
+ * I2C_0_STATIC_CALLBACKS they make no call and only save the registers
+ * the handler needs, on every data byte.
+ *
  * \return Nothing
  */
-void I2C_0_isr()
+static inline __attribute__((always_inline)) void I2C_0_isr_body(void)
 {
-	if (TWI0.SSTATUS & TWI_COLL_bm) {
-		I2C_0_collision_callback();
-		return;
-	}
+	uint8_t status = TWI0.SSTATUS;
+	uint8_t addr;
 
-	if (TWI0.SSTATUS & TWI_BUSERR_bm) {
-		I2C_0_bus_error_callback();
-		return;
+#if I2C_0_BUS_TIMEOUT_ENABLE
+	I2C_0_bus_idle = 0;
+#endif
+
+#if I2C_0_SNIFFER_ENABLE
+	if (I2C_0_sniffing && (status & TWI_APIF_bm)) {
+		if (!(status & TWI_AP_bm)) {
+			I2C_0_sniff_log_event(I2C_SNIFF_STOP);
+		} else {
+			addr = TWI0.SDATA;
+			I2C_0_sniff_log_event(addr);
+			if (!I2C_0_own_address(addr)) {
+				// Another device's transaction: NACK leaves SDA to it, and
+				// the slave waits for the next START
+				TWI0.SCTRLB = TWI_ACKACT_NACK_gc | TWI_SCMD_COMPTRANS_gc;
+				return;
+			}
+		}
 	}
+#endif
 
-	if ((TWI0.SSTATUS & TWI_APIF_bm) && (TWI0.SSTATUS & TWI_AP_bm)) {
-		I2C_0_address_callback();
-		if (TWI0.SSTATUS & TWI_DIR_bm) {
-			// Master wishes to read from slave
-			I2C_0_read_callback();
+	switch (status & (TWI_DIF_bm | TWI_APIF_bm | TWI_COLL_bm | TWI_BUSERR_bm | TWI_DIR_bm | TWI_AP_bm)) {
+	case TWI_DIF_bm | TWI_DIR_bm | TWI_AP_bm:
+	case TWI_DIF_bm | TWI_DIR_bm:
+	case TWI_DIF_bm | TWI_APIF_bm | TWI_DIR_bm:
+		// Master wishes to read from slave
+#if I2C_0_ALERT_ENABLE
+		if (I2C_0_ara) {
+			// Our address went out on the ARA without losing arbitration,
+			// the host knows who alerted. Release the line and finish.
+			I2C_0_ara       = false;
+			I2C_0_addressed = false;
+			I2C_0_alert_off();
+			TWI0.SSTATUS = TWI_DIF_bm | TWI_APIF_bm;
+			TWI0.SCTRLB  = TWI_SCMD_COMPTRANS_gc;
+			return;
+		}
+#endif
+#if I2C_0_ARP_ENABLE
+		if (I2C_0_arp_active && !(status & TWI_RXACK_bm)) {
+			I2C_0_STATS_COUNT(I2C_0_bytes_read);
+			TWI0.SDATA  = I2C_0_arp_read();
 			TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			return;
+		}
+#endif
+		if (!(status & TWI_RXACK_bm)) {
+			// Received ACK from master
+			I2C_0_STATS_COUNT(I2C_0_bytes_read);
+			I2C_0_data_read();
+		} else {
+			// Received NACK from master, the transaction ends here. Go to
+			// unaddressed state, the STOP that follows finds nothing to do.
+			I2C_0_STATS_COUNT(I2C_0_stats.nacks);
+			I2C_0_addressed = false;
+			I2C_0_data_stop();
+			TWI0.SSTATUS = TWI_DIF_bm | TWI_APIF_bm;
+			TWI0.SCTRLB  = TWI_SCMD_COMPTRANS_gc;
 		}
 		return;
-	}
-	if (TWI0.SSTATUS & TWI_DIF_bm) {
-		if (TWI0.SSTATUS & TWI_DIR_bm) {
-			// Master wishes to read from slave
-			if (!(TWI0.SSTATUS & TWI_RXACK_bm)) {
-				// Received ACK from master
-				I2C_0_read_callback();
+
+	case TWI_DIF_bm | TWI_AP_bm:
+	case TWI_DIF_bm:
+	case TWI_DIF_bm | TWI_APIF_bm:
+		// Master wishes to write to slave
+		I2C_0_STATS_COUNT(I2C_0_bytes_written);
+#if I2C_0_ARP_ENABLE
+		if (I2C_0_arp_active) {
+			if (I2C_0_arp_write(TWI0.SDATA)) {
+				TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			} else {
+				TWI0.SCTRLB = TWI_ACKACT_NACK_gc | TWI_SCMD_COMPTRANS_gc;
+			}
+			return;
+		}
+#endif
+#if I2C_0_GENERAL_CALL_ENABLE
+		if (I2C_0_general_call) {
+			if (I2C_0_general_call_callback(TWI0.SDATA)) {
 				TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
 			} else {
-				// Received NACK from master
-				I2C_0_goto_unaddressed();
+				TWI0.SCTRLB = TWI_ACKACT_NACK_gc | TWI_SCMD_COMPTRANS_gc;
 			}
-		} else // Master wishes to write to slave
-		{
-			I2C_0_write_callback();
+			return;
 		}
+#endif
+		I2C_0_data_write();
+		return;
+
+	case TWI_APIF_bm | TWI_DIR_bm | TWI_AP_bm:
+	case TWI_DIF_bm | TWI_APIF_bm | TWI_DIR_bm | TWI_AP_bm:
+		// Address match, master wishes to read from slave, every path sends a byte
+		addr = TWI0.SDATA;
+		I2C_0_stats_start();
+		I2C_0_STATS_COUNT(I2C_0_bytes_read);
+#if I2C_0_ALERT_ENABLE
+		if ((addr >> 1) == I2C_0_ALERT_RESPONSE_ADDRESS) {
+			// Alert Response Address, answer with our own address. Losing
+			// arbitration to a board with a lower address is a collision.
+			I2C_0_ara       = true;
+			I2C_0_addressed = true;
+			TWI0.SDATA      = TWI0.SADDR & TWI_ADDRMASK_gm;
+			TWI0.SCTRLB     = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			return;
+		}
+#endif
+#if I2C_0_ARP_ENABLE
+		I2C_0_arp_active = (addr >> 1) == SMBUS_ARP_ADDRESS;
+		if (I2C_0_arp_active) {
+			// Get UDID, the answer is arbitrated against the other devices
+			I2C_0_arp_address(true, I2C_0_addressed, addr);
+			I2C_0_addressed = true;
+			TWI0.SDATA      = I2C_0_arp_read();
+			TWI0.SCTRLB     = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			return;
+		}
+#endif
+#if I2C_0_REGMAP_ENABLE
+		I2C_0_regmap_address(true, I2C_0_addressed, addr);
+#endif
+		I2C_0_address_callback();
+		I2C_0_addressed = true;
+#if I2C_0_PREFETCH_ENABLE
+		// First byte, after the address callback may have updated the registers
+		I2C_0_regmap_prefetch();
+#endif
+		I2C_0_data_read();
+		return;
+
+	case TWI_APIF_bm | TWI_AP_bm:
+	case TWI_DIF_bm | TWI_APIF_bm | TWI_AP_bm:
+		// Address match, master wishes to write to slave
+		addr = TWI0.SDATA;
+		I2C_0_stats_start();
+#if I2C_0_GENERAL_CALL_ENABLE
+		if (addr == 0x00) {
+			// General call, the data bytes are broadcast commands
+			I2C_0_general_call = true;
+			I2C_0_addressed    = true;
+			TWI0.SCTRLB        = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			return;
+		}
+#endif
+#if I2C_0_ARP_ENABLE
+		I2C_0_arp_active = (addr >> 1) == SMBUS_ARP_ADDRESS;
+		if (I2C_0_arp_active) {
+			I2C_0_arp_address(false, I2C_0_addressed, addr);
+			I2C_0_addressed = true;
+			TWI0.SCTRLB     = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			return;
+		}
+#endif
+#if I2C_0_REGMAP_ENABLE
+		I2C_0_regmap_address(false, I2C_0_addressed, addr);
+#endif
+		I2C_0_address_callback();
+		I2C_0_addressed = true;
+#if I2C_0_REGMAP_ENABLE || I2C_0_BUFFER_ENABLE
+		// The driver accepts every write, data bytes are checked as they come
+		TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+#endif
 		return;
-	}
 
-	// Check if STOP was received
-	if ((TWI0.SSTATUS & TWI_APIF_bm) && (!(TWI0.SSTATUS & TWI_AP_bm))) {
+	case TWI_APIF_bm:
+	case TWI_APIF_bm | TWI_DIR_bm:
+		// STOP received, end of the transaction
+#if I2C_0_GENERAL_CALL_ENABLE
+		I2C_0_general_call = false;
+#endif
+#if I2C_0_ALERT_ENABLE
+		I2C_0_ara = false;
+#endif
+#if I2C_0_ARP_ENABLE
+		I2C_0_arp_active = false;
+#endif
+		if (I2C_0_addressed) {
+			I2C_0_addressed = false;
+			I2C_0_data_stop();
+		}
+		I2C_0_stats_end();
 		I2C_0_stop_callback();
 		TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
 		return;
+
+	default:
+		if (!(status & (TWI_COLL_bm | TWI_BUSERR_bm))) {
+			// Every DIF/APIF combination has a case above, nothing is pending
+			return;
+		}
+#if I2C_0_GENERAL_CALL_ENABLE
+		I2C_0_general_call = false;
+#endif
+#if I2C_0_ALERT_ENABLE
+		// An ARA lost to another board keeps the alert pending
+		I2C_0_ara = false;
+#endif
+#if I2C_0_ARP_ENABLE
+		// A Get UDID lost to another device waits for the next one
+		I2C_0_arp_active = false;
+#endif
+		if (status & TWI_COLL_bm) {
+			I2C_0_STATS_COUNT(I2C_0_stats.collisions);
+			I2C_0_stats_end();
+			I2C_0_addressed = false;
+			I2C_0_data_abort();
+			I2C_0_collision_callback();
+		} else {
+			I2C_0_STATS_COUNT(I2C_0_stats.bus_errors);
+			I2C_0_stats_end();
+			I2C_0_addressed = false;
+			I2C_0_data_abort();
+			I2C_0_bus_error_callback();
+		}
+		// Clear the flags seen, a later event keeps its own
+		TWI0.SSTATUS = status & (TWI_DIF_bm | TWI_APIF_bm | TWI_COLL_bm | TWI_BUSERR_bm);
+		TWI0.SCTRLB  = TWI_SCMD_COMPTRANS_gc;
+		return;
+	}
+}
+
+/**
+ * \brief The function called by the I2C IRQ handler.
+ * Can be called in a polling loop in a polled driver.
+ *
+ * \return Nothing
+ */
+__attribute__((flatten)) void I2C_0_isr()
+{
+	I2C_0_isr_body();
+}
+
+#if I2C_0_STATS_ENABLE
+I2C_0_VECT
+{
+	// TEMP is shared by all 16-bit TCA0 accesses, the interrupted code may
+	// be half way through one. CNT is reloaded by the timeout driver, which
+	// cannot run before this returns, so only the difference is used.
+	uint8_t  temp  = TCA0.SINGLE.TEMP;
+	uint16_t start = TCA0.SINGLE.CNT;
+	uint16_t stretch;
+
+	I2C_0_isr_body();
+	stretch = TCA0.SINGLE.CNT - start;
+	if (stretch > I2C_0_stretch) {
+		I2C_0_stretch = stretch;
 	}
+	TCA0.SINGLE.TEMP = temp;
 }
+#elif I2C_0_SNIFFER_ENABLE
+I2C_0_VECT
+{
+	// The sniffer reads TCA0.SINGLE.CNT, keep TEMP for the interrupted code
+	uint8_t temp = TCA0.SINGLE.TEMP;
 
-ISR(TWI0_TWIS_vect)
+	I2C_0_isr_body();
+	TCA0.SINGLE.TEMP = temp;
+}
+#else
+I2C_0_VECT
 {
-	I2C_0_isr();
+	I2C_0_isr_body();
+}
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+ISR(TWI0_TWIM_vect)
+{
+	uint8_t status = TWI0.MSTATUS;
+
+	if (status & (TWI_ARBLOST_bm | TWI_BUSERR_bm)) {
+		// Lost the bus to another master or saw a misplaced START/STOP.
+		// Not passed to the collision and bus error callbacks: those are
+		// about the slave, which may be serving the very transaction that
+		// won the bus. The notify error callback tells the application.
+		TWI0.MSTATUS = TWI_ARBLOST_bm | TWI_BUSERR_bm;
+		// The slave ISR may have the higher priority, the counters and
+		// the application state are shared with it
+		ENTER_CRITICAL(M);
+#if I2C_0_STATS_ENABLE
+		if (status & TWI_ARBLOST_bm) {
+			I2C_0_STATS_COUNT(I2C_0_stats.collisions);
+		} else {
+			I2C_0_STATS_COUNT(I2C_0_stats.bus_errors);
+		}
+#endif
+		I2C_0_notify_error_callback();
+		EXIT_CRITICAL(M);
+		if (I2C_0_notify_retries) {
+			// Start over, the master waits for the bus to go idle first
+			I2C_0_notify_retries--;
+			I2C_0_notify_index = 0;
+			TWI0.MADDR         = I2C_0_HOST_NOTIFY_ADDRESS << 1;
+		} else {
+			I2C_0_notify_index = I2C_0_NOTIFY_IDLE;
+		}
+		return;
+	}
+
+	if ((status & TWI_RXACK_bm) || I2C_0_notify_index == sizeof(I2C_0_notify_msg)) {
+		// Host NACKed or the message is complete, release the bus
+		TWI0.MCTRLB        = TWI_MCMD_STOP_gc;
+		I2C_0_notify_index = I2C_0_NOTIFY_IDLE;
+		return;
+	}
+
+	TWI0.MDATA = I2C_0_notify_msg[I2C_0_notify_index++];
 }
 
+/**
+ * \brief Send an SMBus Host Notify message to the host
+ *
+ * Becomes bus master as soon as the bus is idle, writes this slave's
+ * address and the data word to the SMBus Host address and returns to
+ * slave mode. A lost arbitration or bus error calls the notify error
+ * callback, is counted in the statistics and retried up to
+ * I2C_0_HOST_NOTIFY_RETRIES times.
+ *
+ * \param[in] data Data word of the message, sent low byte first
+ *
+ * \return false if a previous message is still being sent
+ */
+bool I2C_0_host_notify(uint16_t data)
+{
+	if (I2C_0_notify_index != I2C_0_NOTIFY_IDLE) {
+		return false;
+	}
+
+	I2C_0_notify_msg[0]  = TWI0.SADDR & TWI_ADDRMASK_gm;
+	I2C_0_notify_msg[1]  = data;
+	I2C_0_notify_msg[2]  = data >> 8;
+	I2C_0_notify_retries = I2C_0_HOST_NOTIFY_RETRIES;
+	I2C_0_notify_index   = 0;
+	TWI0.MADDR           = I2C_0_HOST_NOTIFY_ADDRESS << 1;
+	return true;
+}
+
+/**
+ * \brief Check whether a Host Notify message is being sent
+ *
+ * \return true until the message is sent, NACKed or given up
+ */
+bool I2C_0_host_notify_busy(void)
+{
+	return I2C_0_notify_index != I2C_0_NOTIFY_IDLE;
+}
+#endif
+
+#if I2C_0_BUS_TIMEOUT_ENABLE
+/**
+ * \brief Periodic bus stuck check, called by the timeout driver
+ *
+ * Every TWI interrupt is bus activity. When the slave stays addressed for
+ * I2C_0_BUS_CHECKS checks without any, it is disabled and enabled again,
+ * which releases SDA and SCL, and the transaction is dropped as on a bus
+ * error. I2C_0_init is not used for this as it would uninstall the
+ * callbacks.
+ *
+ * \param[in] payload Unused
+ *
+ * \return Ticks until the next check
+ */
+static absolutetime_t I2C_0_bus_check(void *payload)
+{
+#if I2C_0_SNIFFER_ENABLE
+	if (I2C_0_sniffing) {
+		// Expired just before the sniffer started, I2C_0_sniffer_stop restarts it
+		return 0;
+	}
+#endif
+	ENTER_CRITICAL(B);
+	if (!I2C_0_addressed) {
+		I2C_0_bus_idle = 0;
+	} else if (++I2C_0_bus_idle >= I2C_0_BUS_CHECKS) {
+		I2C_0_close();
+		I2C_0_bus_idle  = 0;
+		I2C_0_addressed = false;
+#if I2C_0_GENERAL_CALL_ENABLE
+		I2C_0_general_call = false;
+#endif
+#if I2C_0_ALERT_ENABLE
+		I2C_0_ara = false;
+#endif
+#if I2C_0_ARP_ENABLE
+		I2C_0_arp_active = false;
+#endif
+		I2C_0_data_abort();
+		I2C_0_stats_end();
+		if (I2C_0_bus_timeouts != 0xff) {
+			I2C_0_bus_timeouts++;
+		}
+		I2C_0_bus_error_callback();
+		TWI0.SSTATUS = TWI_DIF_bm | TWI_APIF_bm | TWI_COLL_bm | TWI_BUSERR_bm;
+		I2C_0_open();
+	}
+	EXIT_CRITICAL(B);
+	return I2C_0_BUS_CHECK_TICKS;
+}
+
+/**
+ * \brief Number of times the slave recovered from a stuck bus
+ *
+ * \return Recoveries since reset, saturates at 255
+ */
+uint8_t I2C_0_get_bus_timeouts(void)
+{
+	return I2C_0_bus_timeouts;
+}
+#endif
+
+#if I2C_0_SNIFFER_ENABLE
+/**
+ * \brief Start logging the bus traffic into I2C_0_sniff_log
+ *
+ * Clears the log and turns on promiscuous mode. Every address byte and
+ * every STOP on the bus is logged with the TCA0 count. Transactions to
+ * this slave are served as usual, the others are NACKed, which leaves the
+ * bus to the addressed device. Their data bytes cannot be logged: the TWI
+ * only receives data after ACKing the address. The slave still stretches
+ * SCL for the address byte of every transaction while the ISR runs.
+ *
+ * TCA0 is switched to I2C_0_SNIFFER_CLKSEL and runs free, the bus stuck
+ * check is paused. The longest stretch of the statistics restarts, it is
+ * counted in TCA0 ticks. Call from the main loop.
+ *
+ * \return Nothing
+ */
+void I2C_0_sniffer_start(void)
+{
+#if I2C_0_BUS_TIMEOUT_ENABLE
+	TIMER_0_timeout_delete(&I2C_0_bus_timer);
+#endif
+	ENTER_CRITICAL(S);
+	I2C_0_sniff_log.head  = 0;
+	I2C_0_sniff_log.count = 0;
+	TCA0.SINGLE.CTRLA     = I2C_0_SNIFFER_CLKSEL | 1 << TCA_SINGLE_ENABLE_bp;
+	I2C_0_sniffing        = true;
+	TWI0.SCTRLA |= TWI_PMEN_bm;
+#if I2C_0_STATS_ENABLE
+	// The stretch is counted in the new TCA0 ticks from now on
+	I2C_0_stretch           = 0;
+	I2C_0_stats.stretch_max = 0;
+#endif
+	EXIT_CRITICAL(S);
+}
+
+/**
+ * \brief Stop logging, the log is kept until the next start
+ *
+ * Restores the system clock to TCA0 and restarts the bus stuck check.
+ * The longest stretch of the statistics restarts again. Call from the
+ * main loop.
+ *
+ * \return Nothing
+ */
+void I2C_0_sniffer_stop(void)
+{
+	ENTER_CRITICAL(S);
+	TWI0.SCTRLA &= ~TWI_PMEN_bm;
+	I2C_0_sniffing    = false;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | 1 << TCA_SINGLE_ENABLE_bp;
+#if I2C_0_STATS_ENABLE
+	I2C_0_stretch           = 0;
+	I2C_0_stats.stretch_max = 0;
+#endif
+	EXIT_CRITICAL(S);
+#if I2C_0_BUS_TIMEOUT_ENABLE
+	TIMER_0_timeout_delete(&I2C_0_bus_timer);
+	TIMER_0_timeout_create(&I2C_0_bus_timer, I2C_0_BUS_CHECK_TICKS);
+#endif
+}
+
+/**
+ * \brief Check whether the sniffer is logging
+ *
+ * \return true between I2C_0_sniffer_start and I2C_0_sniffer_stop
+ */
+bool I2C_0_sniffer_active(void)
+{
+	return I2C_0_sniffing;
+}
+#endif
+
+/**
+ * \brief Change the slave address
+ *
+ * Takes effect with the next START. With I2C_0_ADDRESS_MASK the slave
+ * answers on the whole group of addresses around the new address.
+ *
+ * \param[in] address 7-bit slave address
+ *
+ * \return Nothing
+ */
+void I2C_0_set_address(uint8_t address)
+{
+	ENTER_CRITICAL(A);
+	TWI0.SADDR = address << TWI_ADDRMASK_gp | I2C_0_GENERAL_CALL_ENABLE << TWI_ADDREN_bp;
+#if !I2C_0_ADDRESS_MASK && !I2C_0_ARP_ENABLE
+#if I2C_0_ALERT_ENABLE
+	// A pending alert keeps the Alert Response Address until it is read
+	if (!I2C_0_alert_pending())
+#endif
+		TWI0.SADDRMASK = address << TWI_ADDRMASK_gp | 1 << TWI_ADDREN_bp;
+#endif
+	EXIT_CRITICAL(A);
+}
+
+/**
+ * \brief Get the slave address
+ *
+ * \return 7-bit slave address
+ */
+uint8_t I2C_0_get_address(void)
+{
+	return TWI0.SADDR >> TWI_ADDRMASK_gp;
+}
+
+/**
+ * \brief Change the bus speed class and SDA timing at run time
+ *
+ * CTRLA may only be changed while the TWI is disabled, so the slave (and
+ * the Host Notify master) is disabled around the write. Call while no
+ * transaction is in progress, a transfer on the bus is not answered while
+ * the TWI is off.
+ *
+ * \param[in] ctrla TWI_FMPEN_bm, a TWI_SDAHOLD_*_gc and a TWI_SDASETUP_*_gc value
+ *
+ * \return Nothing
+ */
+void I2C_0_set_timing(uint8_t ctrla)
+{
+	uint8_t sctrla, mctrla;
+
+	// Read them in the critical section, nothing may change them before they are written back
+	ENTER_CRITICAL(T);
+	sctrla = TWI0.SCTRLA;
+	mctrla = TWI0.MCTRLA;
+	TWI0.SCTRLA = sctrla & ~TWI_ENABLE_bm;
+	TWI0.MCTRLA = mctrla & ~TWI_ENABLE_bm;
+	TWI0.CTRLA  = ctrla;
+	TWI0.MCTRLA = mctrla;
+	if (mctrla & TWI_ENABLE_bm) {
+		TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
+	}
+	TWI0.SCTRLA = sctrla;
+	EXIT_CRITICAL(T);
+}
+
+/**
+ * \brief Check whether the current address match is a repeated START
+ *
+ * Only meaningful from the address callback, which runs before the driver
+ * marks the transaction as started.
+ *
+ * \return true if the slave was already addressed since the last STOP
+ */
+bool I2C_0_is_repeated_start(void)
+{
+	return I2C_0_addressed;
+}
+
+#if I2C_0_ALERT_ENABLE
+/**
+ * \brief Assert SMBALERT# and answer the SMBus Alert Response Address
+ *
+ * The host reads the Alert Response Address to find out which board
+ * alerted. The board with the lowest address wins the arbitration and
+ * releases its alert, the others keep it asserted for the next ARA.
+ *
+ * \return Nothing
+ */
+void I2C_0_alert_assert(void)
+{
+	ENTER_CRITICAL(A);
+	TWI0.SADDRMASK          = I2C_0_ALERT_RESPONSE_ADDRESS << TWI_ADDRMASK_gp | 1 << TWI_ADDREN_bp;
+	I2C_0_ALERT_PORT.DIRSET = 1 << I2C_0_ALERT_PIN;
+	EXIT_CRITICAL(A);
+}
+
+/**
+ * \brief Release SMBALERT# without waiting for the host to read the ARA
+ *
+ * \return Nothing
+ */
+void I2C_0_alert_release(void)
+{
+	ENTER_CRITICAL(A);
+	I2C_0_alert_off();
+	EXIT_CRITICAL(A);
+}
+
+/**
+ * \brief Check whether SMBALERT# is asserted
+ *
+ * \return true until the host has read this board's address from the ARA
+ */
+bool I2C_0_alert_pending(void)
+{
+	return I2C_0_ALERT_PORT.DIR & (1 << I2C_0_ALERT_PIN);
+}
+#endif
+
 /**
  * \brief Read one byte from the data register of I2C_0
  *
@@ -207,6 +1144,49 @@ void I2C_0_write(uint8_t data)
 	TWI0.SCTRLB |= TWI_SCMD_RESPONSE_gc;
 }
 
+#if I2C_0_BUFFER_ENABLE
+/**
+ * \brief Hand the driver the buffers for the next transactions of I2C_0
+ *
+ * Bytes written by the master are stored in rx and bytes read by the
+ * master are taken from tx, without calling back per byte. A write past
+ * the end of rx is NACKed, a read past the end of tx returns
+ * I2C_0_REGMAP_FILL. Both counts restart when the transaction ends, after the transfer
+ * callback has been called, so the buffers may be replaced from there.
+ *
+ * \param[in] tx      Data the master reads, may be NULL if tx_size is 0
+ * \param[in] tx_size Number of bytes in tx
+ * \param[in] rx      Storage for the data the master writes, may be NULL if rx_size is 0
+ * \param[in] rx_size Number of bytes rx can hold
+ *
+ * \return Nothing
+ */
+void I2C_0_set_buffers(const volatile uint8_t *tx, uint8_t tx_size, volatile uint8_t *rx, uint8_t rx_size)
+{
+	ENTER_CRITICAL(B);
+	I2C_0_buffer.tx       = tx;
+	I2C_0_buffer.tx_size  = tx_size;
+	I2C_0_buffer.tx_count = 0;
+	I2C_0_buffer.rx       = rx;
+	I2C_0_buffer.rx_size  = rx_size;
+	I2C_0_buffer.rx_count = 0;
+	EXIT_CRITICAL(B);
+}
+
+#if !I2C_0_STATIC_CALLBACKS
+/**
+ * \brief Callback handler for the end of a transaction, called at STOP
+ * with the number of bytes received into rx and sent from tx.
+ *
+ * \return Nothing
+ */
+void I2C_0_set_transfer_callback(i2c_transfer_callback handler)
+{
+	I2C_0_transfer_interrupt_handler = handler;
+}
+#endif
+#endif
+
 /**
  * \brief Enable address recognition in I2C_0
  * 1. If supported by the clock system, enables the clock to the module
@@ -254,6 +1234,7 @@ void I2C_0_goto_unaddressed(void)
 	TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
 }
 
+#if !I2C_0_STATIC_CALLBACKS
 // Read Event Interrupt Handlers
 void I2C_0_read_callback(void)
 {
@@ -361,3 +1342,48 @@ void I2C_0_set_bus_error_callback(i2c_callback handler)
 {
 	I2C_0_bus_error_interrupt_handler = handler;
 }
+#if I2C_0_GENERAL_CALL_ENABLE
+// General Call Command Interrupt Handlers
+bool I2C_0_general_call_callback(uint8_t command)
+{
+	if (I2C_0_general_call_interrupt_handler) {
+		return I2C_0_general_call_interrupt_handler(command);
+	}
+	return false;
+}
+
+/**
+ * \brief Callback handler for a command byte received with a general call.
+ * The handler returns true to ACK the command, commands nobody handles are NACKed.
+ *
+ * \return Nothing
+ */
+void I2C_0_set_general_call_callback(i2c_general_call_callback handler)
+{
+	I2C_0_general_call_interrupt_handler = handler;
+}
+#endif
+
+#if I2C_0_HOST_NOTIFY_ENABLE
+// Host Notify Error Interrupt Handlers
+void I2C_0_notify_error_callback(void)
+{
+	if (I2C_0_notify_error_interrupt_handler) {
+		I2C_0_notify_error_interrupt_handler();
+	}
+}
+
+/**
+ * \brief Callback handler for a lost arbitration or bus error of the Host
+ * Notify master. Called from the master interrupt, before the message is
+ * retried. The slave keeps its transaction, its callbacks are not called.
+ *
+ * \return Nothing
+ */
+void I2C_0_set_notify_error_callback(i2c_callback handler)
+{
+	I2C_0_notify_error_interrupt_handler = handler;
+}
+#endif
+
+#endif /* !I2C_0_STATIC_CALLBACKS */
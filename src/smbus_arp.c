@@ -0,0 +1,45 @@
+/**
+ * \file
+ *
+ * \brief SMBus Address Resolution Protocol for the I2C slave.
+ *
+ */
+
+#include <smbus_arp.h>
+
+#if I2C_0_ARP_ENABLE
+
+i2c_arp_t I2C_0_arp;
+
+/**
+ * \brief Build the UDID and reset the ARP flags, the address is valid
+ *
+ * UDID layout, most significant byte first: device capabilities, version,
+ * vendor ID, device ID, interface, subsystem vendor ID, subsystem device
+ * ID, vendor specific ID. The subsystem IDs and the vendor specific ID
+ * carry SERNUM2..SERNUM9 of the signature row, the lot, wafer and die
+ * position of the chip.
+ *
+ * \return Nothing
+ */
+void I2C_0_arp_init(void)
+{
+	volatile uint8_t *sernum = &SIGROW.SERNUM2;
+	uint8_t *         udid   = I2C_0_arp.udid;
+
+	*udid++ = 0x81;                         // Dynamic and volatile address, PEC supported
+	*udid++ = 0x08;                         // UDID version 1, silicon revision 0
+	*udid++ = I2C_0_ARP_VENDOR_ID >> 8;
+	*udid++ = I2C_0_ARP_VENDOR_ID & 0xff;
+	*udid++ = I2C_0_ARP_DEVICE_ID >> 8;
+	*udid++ = I2C_0_ARP_DEVICE_ID & 0xff;
+	*udid++ = 0x00;                         // Interface: SMBus version 2.0
+	*udid++ = 0x04;
+	for (uint8_t i = 0; i < 8; i++) {
+		*udid++ = sernum[i];
+	}
+
+	I2C_0_arp.flags = SMBUS_ARP_AV;
+}
+
+#endif